@@ -0,0 +1,366 @@
+#include "AnsCoder.h"
+#include "BinaryIO.h"
+#include "Stats.h"
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+int floorLog2(uint32_t value) {
+    int log = 0;
+    while (value >>= 1) ++log;
+    return log;
+}
+
+struct EncodeEntry {
+    uint32_t deltaBits;    // Bits to write are (state + deltaBits) >> 16
+    int32_t deltaState;    // Added to the reduced state to index the encode table
+};
+
+struct DecodeEntry {
+    uint16_t baseState;   // Next state before the bits read for this slot are added
+    uint8_t symbol;
+    uint8_t bitCount;
+};
+
+void countSymbols(const std::unordered_map<char, int>& freqMap, uint64_t counts[256], uint64_t& total, size_t& symbolCount) {
+    std::fill(counts, counts + 256, 0);
+    total = 0;
+    symbolCount = 0;
+    for (const auto& pair : freqMap) {
+        if (pair.second <= 0) continue;
+        counts[static_cast<unsigned char>(pair.first)] = static_cast<uint64_t>(pair.second);
+        total += static_cast<uint64_t>(pair.second);
+        symbolCount++;
+    }
+}
+
+size_t headerSize(size_t symbolCount) {
+    return sizeof(uint8_t) + sizeof(uint16_t) + symbolCount * (sizeof(uint8_t) + sizeof(uint16_t)) +
+           sizeof(uint32_t) + sizeof(uint64_t);
+}
+
+} // namespace
+
+// About one slot per input byte, up to MAX_TABLE_LOG, and always room for every symbol
+int AnsCoder::tableLogFor(uint64_t total, size_t symbolCount) {
+    int tableLog = MIN_TABLE_LOG;
+    while (tableLog < MAX_TABLE_LOG && (uint64_t(1) << tableLog) < total) ++tableLog;
+    while ((size_t(1) << tableLog) < symbolCount) ++tableLog;
+    return tableLog;
+}
+
+void AnsCoder::normalize(const uint64_t counts[256], int tableLog, uint32_t normalized[256]) {
+    const uint64_t tableSize = uint64_t(1) << tableLog;
+    uint64_t total = 0;
+    for (int s = 0; s < 256; ++s) total += counts[s];
+
+    int64_t sum = 0;
+    for (int s = 0; s < 256; ++s) {
+        normalized[s] = 0;
+        if (counts[s] == 0) continue;
+        uint64_t scaled = (counts[s] * tableSize + total / 2) / total;
+        normalized[s] = static_cast<uint32_t>(std::max<uint64_t>(scaled, 1));
+        sum += normalized[s];
+    }
+
+    // Bits the block gains or loses if a symbol gets one more or one fewer slot
+    auto gain = [&](int s) { return counts[s] * std::log2((normalized[s] + 1.0) / normalized[s]); };
+    auto loss = [&](int s) {
+        return normalized[s] > 1 ? counts[s] * std::log2(normalized[s] / (normalized[s] - 1.0)) : INFINITY;
+    };
+    double change[256];
+    if (sum > static_cast<int64_t>(tableSize)) {
+        for (int s = 0; s < 256; ++s) change[s] = counts[s] ? loss(s) : INFINITY;
+        for (; sum > static_cast<int64_t>(tableSize); --sum) {
+            int s = static_cast<int>(std::min_element(change, change + 256) - change);
+            normalized[s]--;
+            change[s] = loss(s);
+        }
+    } else if (sum < static_cast<int64_t>(tableSize)) {
+        for (int s = 0; s < 256; ++s) change[s] = counts[s] ? gain(s) : -1;
+        for (; sum < static_cast<int64_t>(tableSize); ++sum) {
+            int s = static_cast<int>(std::max_element(change, change + 256) - change);
+            normalized[s]++;
+            change[s] = gain(s);
+        }
+    }
+}
+
+// The step is odd, so it visits every slot once before returning to 0
+void AnsCoder::spread(const uint32_t normalized[256], int tableLog, uint8_t* symbols) {
+    const uint32_t tableSize = 1u << tableLog;
+    const uint32_t step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    uint32_t position = 0;
+    for (int s = 0; s < 256; ++s) {
+        for (uint32_t i = 0; i < normalized[s]; ++i) {
+            symbols[position] = static_cast<uint8_t>(s);
+            position = (position + step) & (tableSize - 1);
+        }
+    }
+}
+
+size_t AnsCoder::estimatePayload(const std::unordered_map<char, int>& freqMap) {
+    uint64_t counts[256];
+    uint64_t total;
+    size_t symbolCount;
+    countSymbols(freqMap, counts, total, symbolCount);
+    if (total == 0) return headerSize(0);
+
+    int tableLog = tableLogFor(total, symbolCount);
+    uint32_t normalized[256];
+    normalize(counts, tableLog, normalized);
+    double bits = tableLog;
+    for (int s = 0; s < 256; ++s) {
+        if (counts[s] > 0) bits += counts[s] * (tableLog - std::log2(static_cast<double>(normalized[s])));
+    }
+    return headerSize(symbolCount) + static_cast<size_t>(std::ceil(bits / 8));
+}
+
+size_t AnsCoder::estimateStream(const AnsTable& table, const std::unordered_map<char, int>& freqMap) {
+    double bits = STATES * table.tableLog;
+    for (const auto& pair : freqMap) {
+        if (pair.second <= 0) continue;
+        uint32_t slots = table.normalized[static_cast<unsigned char>(pair.first)];
+        if (slots == 0) return SIZE_MAX;
+        bits += pair.second * (table.tableLog - std::log2(static_cast<double>(slots)));
+    }
+    return sizeof(uint32_t) + sizeof(uint64_t) + static_cast<size_t>(std::ceil(bits / 8));
+}
+
+std::string AnsCoder::compress(const std::string& text, const std::unordered_map<char, int>& freqMap) {
+    uint64_t counts[256];
+    uint64_t total;
+    size_t symbolCount;
+    countSymbols(freqMap, counts, total, symbolCount);
+
+    AnsTable table;
+    table.tableLog = tableLogFor(total, symbolCount);
+    if (total > 0) {
+        ScopedPhase phase("tree_build");
+        normalize(counts, table.tableLog, table.normalized);
+    }
+
+    std::ostringstream out(std::ios::binary);
+    writeValue<uint8_t>(out, static_cast<uint8_t>(table.tableLog));
+    writeValue<uint16_t>(out, static_cast<uint16_t>(symbolCount));
+    for (int s = 0; s < 256; ++s) {
+        if (table.normalized[s] == 0) continue;
+        writeValue<uint8_t>(out, static_cast<uint8_t>(s));
+        writeValue<uint16_t>(out, static_cast<uint16_t>(table.normalized[s]));
+    }
+    writeStream(out, text, table);
+    return out.str();
+}
+
+void AnsCoder::writeStream(std::ostream& out, const std::string& text, const AnsTable& table) {
+    const int tableLog = table.tableLog;
+    const uint32_t* normalized = table.normalized;
+    const uint32_t tableSize = 1u << tableLog;
+
+    std::vector<uint16_t> encodeTable(tableSize);
+    EncodeEntry entries[256] = {};
+    {
+        ScopedPhase phase("tree_build");
+        std::vector<uint8_t> symbols(tableSize);
+        spread(normalized, tableLog, symbols.data());
+
+        // Slot u holds the state tableSize + u; a symbol's slots in table order
+        // take the reduced states normalized .. 2 * normalized - 1
+        uint32_t start[256];
+        uint32_t next = 0;
+        for (int s = 0; s < 256; ++s) {
+            start[s] = next;
+            next += normalized[s];
+            if (normalized[s] == 0) continue;
+            uint32_t maxBits = tableLog - floorLog2(normalized[s]);
+            entries[s].deltaBits = (maxBits << 16) - (normalized[s] << maxBits);
+            entries[s].deltaState = static_cast<int32_t>(start[s]) - static_cast<int32_t>(normalized[s]);
+        }
+        uint32_t filled[256] = {0};
+        for (uint32_t u = 0; u < tableSize; ++u) {
+            uint8_t s = symbols[u];
+            encodeTable[start[s] + filled[s]++] = static_cast<uint16_t>(tableSize + u);
+        }
+    }
+
+    writeValue<uint32_t>(out, static_cast<uint32_t>(text.length()));
+
+    ScopedPhase phase("encode");
+
+    // Symbols are coded last to first, so their bits are prepended: completed
+    // bytes come off the low end of the accumulator and fill the buffer from its end
+    std::string packed(text.length() * MAX_TABLE_LOG / 8 + 16, '\0');
+    size_t front = packed.length();
+    uint64_t accumulator = 0;
+    int pending = 0;
+    auto flush = [&]() {
+        while (pending >= 8) {
+            packed[--front] = static_cast<char>(accumulator & 0xFF);
+            accumulator >>= 8;
+            pending -= 8;
+        }
+    };
+
+    // Even and odd positions use separate states, so two dependency chains overlap
+    uint32_t states[STATES] = {tableSize, tableSize};
+    auto encodeSymbol = [&](uint32_t& state, unsigned char s) {
+        // One bit fewer below normalized << maxBits, leaving state >> bits in [normalized, 2 * normalized)
+        const EncodeEntry& entry = entries[s];
+        uint32_t bits = (state + entry.deltaBits) >> 16;
+        accumulator |= static_cast<uint64_t>(state & ((1u << bits) - 1)) << pending;
+        pending += bits;
+        state = encodeTable[static_cast<int32_t>(state >> bits) + entry.deltaState];
+    };
+    for (char ch : text) {
+        if (normalized[static_cast<unsigned char>(ch)] == 0) {
+            throw std::invalid_argument("Symbol frequencies do not cover the text");
+        }
+    }
+    size_t i = text.length();
+    if (i % 2 == 1) {
+        --i;
+        encodeSymbol(states[0], static_cast<unsigned char>(text[i]));
+    }
+    uint32_t even = states[0], odd = states[1];
+    while (i > 0) {
+        i -= 2;
+        encodeSymbol(odd, static_cast<unsigned char>(text[i + 1]));
+        encodeSymbol(even, static_cast<unsigned char>(text[i]));
+        if (pending >= 32) flush();
+    }
+    states[0] = even;
+    states[1] = odd;
+    for (int k = STATES; k-- > 0;) {
+        accumulator |= static_cast<uint64_t>(states[k] - tableSize) << pending;
+        pending += tableLog;
+        flush();
+    }
+    flush();
+    uint64_t bitCount = (packed.length() - front) * 8 + pending;
+    if (pending > 0) {
+        packed[--front] = static_cast<char>(accumulator);
+    }
+    packed.erase(0, front);
+
+    writeValue<uint64_t>(out, bitCount);
+    out << packed;
+}
+
+std::string AnsCoder::decompress(const std::string& payload, uint64_t rawSize) {
+    std::istringstream in(payload, std::ios::binary);
+    AnsTable table = readTable(in);
+    return readStream(in, table, rawSize);
+}
+
+AnsTable AnsCoder::readTable(std::istream& in) {
+    AnsTable table;
+    table.tableLog = readValue<uint8_t>(in);
+    uint16_t symbolCount = readValue<uint16_t>(in);
+    if (table.tableLog < MIN_TABLE_LOG || table.tableLog > MAX_TABLE_LOG || symbolCount > 256) {
+        throw std::runtime_error("Corrupt ANS table");
+    }
+
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < symbolCount; ++i) {
+        uint8_t symbol = readValue<uint8_t>(in);
+        uint16_t frequency = readValue<uint16_t>(in);
+        if (frequency == 0 || table.normalized[symbol] != 0) {
+            throw std::runtime_error("Corrupt ANS table");
+        }
+        table.normalized[symbol] = frequency;
+        sum += frequency;
+    }
+    // Only an empty block has no symbols
+    if (symbolCount > 0 && sum != (uint64_t(1) << table.tableLog)) {
+        throw std::runtime_error("Corrupt ANS table");
+    }
+    return table;
+}
+
+std::string AnsCoder::readStream(std::istream& in, const AnsTable& ansTable, uint64_t rawSize) {
+    const int tableLog = ansTable.tableLog;
+    const uint32_t* normalized = ansTable.normalized;
+    const uint32_t tableSize = 1u << tableLog;
+
+    uint32_t length = readValue<uint32_t>(in);
+    if (length != rawSize) {
+        throw std::runtime_error("ANS length does not match block size");
+    }
+    uint64_t bitCount = readValue<uint64_t>(in);
+    std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (length == 0) {
+        return std::string();
+    }
+    if (std::count(normalized, normalized + 256, 0u) == 256) {
+        throw std::runtime_error("Empty ANS table for a non-empty block");
+    }
+    if (bitCount < static_cast<uint64_t>(STATES * tableLog) || (bitCount + 7) / 8 != packed.length()) {
+        throw std::runtime_error("Packed bit count does not match payload size");
+    }
+
+    std::vector<DecodeEntry> table(tableSize);
+    {
+        ScopedPhase phase("tree_load");
+        std::vector<uint8_t> symbols(tableSize);
+        spread(normalized, tableLog, symbols.data());
+        uint32_t next[256];
+        std::copy(normalized, normalized + 256, next);
+        for (uint32_t u = 0; u < tableSize; ++u) {
+            uint8_t s = symbols[u];
+            uint32_t reduced = next[s]++;
+            uint8_t bits = static_cast<uint8_t>(tableLog - floorLog2(reduced));
+            table[u] = DecodeEntry{static_cast<uint16_t>((reduced << bits) - tableSize), s, bits};
+        }
+    }
+
+    ScopedPhase phase("decode");
+    std::string text(length, '\0');
+    uint64_t window = 0;   // Low windowBits bits are unread input, zero padded past the end
+    int windowBits = 0;
+    size_t bytePos = 0;
+    // Stops below 64 bits: a symbol with no state bits shifts the window by all of them
+    auto refill = [&]() {
+        while (windowBits < 56) {
+            uint8_t byte = bytePos < packed.length() ? static_cast<uint8_t>(packed[bytePos]) : 0;
+            window = (window << 8) | byte;
+            ++bytePos;
+            windowBits += 8;
+        }
+    };
+
+    refill();
+    windowBits -= static_cast<int>(packed.length() * 8 - bitCount);   // Front padding
+    uint32_t states[STATES];
+    for (uint32_t& state : states) {
+        windowBits -= tableLog;
+        state = static_cast<uint32_t>(window >> windowBits) & (tableSize - 1);
+    }
+    uint64_t consumed = STATES * tableLog;
+    auto decodeSymbol = [&](uint32_t& state, uint32_t i) {
+        const DecodeEntry& entry = table[state];
+        text[i] = static_cast<char>(entry.symbol);
+        windowBits -= entry.bitCount;
+        state = entry.baseState + (static_cast<uint32_t>(window >> windowBits) & ((1u << entry.bitCount) - 1));
+        consumed += entry.bitCount;
+    };
+    uint32_t even = states[0], odd = states[1];
+    uint32_t i = 0;
+    for (; i + 1 < length; i += 2) {
+        refill();
+        decodeSymbol(even, i);
+        decodeSymbol(odd, i + 1);
+    }
+    if (i < length) {
+        refill();
+        decodeSymbol(even, i);
+    }
+    if (consumed != bitCount) {
+        throw std::runtime_error("ANS bit stream length mismatch");
+    }
+    return text;
+}
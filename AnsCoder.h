@@ -0,0 +1,65 @@
+#ifndef ANSCODER_H
+#define ANSCODER_H
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Normalized frequencies summing to 2^tableLog; a payload carries one, and a
+// BLOCK_REUSE block may code with the table of an earlier BLOCK_ANS block
+struct AnsTable {
+    int tableLog = 0;
+    uint32_t normalized[256] = {0};
+};
+
+// Table-based asymmetric numeral systems (tANS) over block bytes. Symbol
+// frequencies are normalized to a power-of-two table, so a symbol costs its
+// fractional information content instead of a whole number of bits: a block
+// of one repeated byte codes to nothing but its header.
+//
+// Payload: the table (uint8 table log, uint16 symbol count, then (uint8
+// symbol, uint16 normalized frequency) per symbol) and the stream (uint32 text
+// length, uint64 bit count and the bits packed MSB first, in the packBits
+// layout zero padded at the front: the decoder's initial states, then the bits
+// of each symbol in text order).
+class AnsCoder {
+public:
+    static const int MIN_TABLE_LOG = 5;
+    static const int MAX_TABLE_LOG = 12;
+    static const int STATES = 2;   // Interleaved coder states; even positions use the first
+
+    // Payload size for text with these frequencies, estimated from the
+    // information content under the normalized table
+    static size_t estimatePayload(const std::unordered_map<char, int>& freqMap);
+
+    // freqMap must count every byte of text; the counts may be scaled
+    static std::string compress(const std::string& text, const std::unordered_map<char, int>& freqMap);
+
+    // rawSize is the length the block header promises; a symbol can cost no
+    // bits, so the payload alone cannot bound the length it claims
+    static std::string decompress(const std::string& payload, uint64_t rawSize);
+
+    // The halves of a payload, for coding with the table of another block
+    static AnsTable readTable(std::istream& in);
+    static void writeStream(std::ostream& out, const std::string& text, const AnsTable& table);
+    static std::string readStream(std::istream& in, const AnsTable& table, uint64_t rawSize);
+
+    // Stream size for text with these frequencies under table, or SIZE_MAX if
+    // the table has no slot for one of its bytes
+    static size_t estimateStream(const AnsTable& table, const std::unordered_map<char, int>& freqMap);
+
+private:
+    static int tableLogFor(uint64_t total, size_t symbolCount);
+
+    // Scales counts to sum to 2^tableLog, keeping every present symbol at
+    // least 1 and spending rounding where it costs the fewest bits
+    static void normalize(const uint64_t counts[256], int tableLog, uint32_t normalized[256]);
+
+    // Symbol of every table slot; each symbol's slots are spread out
+    static void spread(const uint32_t normalized[256], int tableLog, uint8_t* symbols);
+};
+
+#endif // ANSCODER_H
@@ -0,0 +1,184 @@
+#include "Appender.h"
+#include "HuffmanTree.h"
+#include "AnsCoder.h"
+#include "BinaryIO.h"
+#include "Search.h"
+#include "Stats.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+
+// Where the table a block was coded with lives, if it has one we can point to
+bool Appender::treeSource(std::istream& in, uint64_t blockOffset, uint64_t& treeOffset) {
+    in.clear();
+    in.seekg(blockOffset);
+    uint8_t mode = readValue<uint8_t>(in);
+    if (mode == BLOCK_HUFFMAN || mode == BLOCK_ANS) {
+        treeOffset = blockOffset;
+        return true;
+    }
+    if (mode == BLOCK_REUSE) {
+        in.seekg(blockOffset + Compressor::BLOCK_HEADER_SIZE);
+        treeOffset = readValue<uint64_t>(in);
+        return true;
+    }
+    return false;
+}
+
+Appender::Layout Appender::scan(std::istream& in) {
+    Layout layout;
+    layout.haveTree = false;
+    layout.treeOffset = 0;
+
+    in.seekg(0, std::ios::end);
+    layout.fileSize = static_cast<uint64_t>(in.tellg());
+
+    char magic[4];
+    in.seekg(0);
+    if (!in.read(magic, sizeof(magic)) || !Compressor::isCompressed(std::string(magic, sizeof(magic)))) {
+        throw std::runtime_error("Not a compressed file (bad magic)");
+    }
+
+    layout.seekable = Compressor::readIndex(in, layout.index);
+    if (layout.seekable) {
+        // Only the index is read; newest blocks are checked first for a tree
+        layout.blocksEnd = layout.fileSize - (1 + layout.index.size() * (2 * sizeof(uint64_t) + sizeof(uint32_t))
+                                              + sizeof(uint32_t) + sizeof(Compressor::INDEX_MAGIC));
+        layout.rawSize = layout.index.empty() ? 0 : layout.index.back().rawOffset + layout.index.back().rawSize;
+        for (size_t i = layout.index.size(); i-- > 0 && !layout.haveTree;) {
+            layout.haveTree = treeSource(in, layout.index[i].fileOffset, layout.treeOffset);
+        }
+        return layout;
+    }
+
+    // No index: walk the block headers, seeking over payloads
+    uint64_t pos = sizeof(Compressor::MAGIC);
+    layout.rawSize = 0;
+    while (pos < layout.fileSize) {
+        in.clear();
+        in.seekg(pos);
+        BlockHeader header;
+        header.mode = static_cast<BlockMode>(readValue<uint8_t>(in));
+        if (header.mode == BLOCK_INDEX) break;
+        header.rawSize = readValue<uint32_t>(in);
+        header.payloadSize = readValue<uint32_t>(in);
+
+        uint64_t treeOffset;
+        if (treeSource(in, pos, treeOffset)) {
+            layout.haveTree = true;
+            layout.treeOffset = treeOffset;
+        }
+        layout.rawSize += header.rawSize;
+        pos += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+    }
+    if (pos > layout.fileSize) {
+        throw std::runtime_error("Truncated block payload");
+    }
+    layout.blocksEnd = pos;
+    return layout;
+}
+
+AppendResult Appender::append(const std::string& path, const std::string& text, const CompressOptions& options) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open compressed file");
+    }
+
+    Layout layout;
+    {
+        ScopedPhase phase("scan");
+        layout = scan(file);
+    }
+
+    CompressOptions blockOptions = options;
+    if (layout.seekable) {
+        blockOptions.seekable = true;
+        blockOptions.blockSize = Compressor::SEEKABLE_BLOCK_SIZE;
+    }
+
+    HuffmanTree reference;
+    AnsTable referenceAns;
+    if (layout.haveTree) {
+        if (Compressor::loadBlockTable(file, layout.treeOffset, reference, referenceAns) == BLOCK_ANS) {
+            blockOptions.referenceAns = &referenceAns;
+        } else {
+            blockOptions.referenceTree = &reference;
+        }
+        blockOptions.referenceTreeOffset = layout.treeOffset;
+    }
+
+    // Seekable files grow past the old index, which stays valid until the new
+    // one is written. An empty index is too small to become a skip block, and
+    // guards no data, so it is simply overwritten.
+    bool keepOldIndex = layout.seekable && !layout.index.empty();
+    uint64_t writeOffset = keepOldIndex ? layout.fileSize : layout.blocksEnd;
+    std::vector<BlockIndexEntry> index = layout.index;
+
+    std::ostringstream added(std::ios::binary);
+    std::vector<BlockFilter> filters;
+    for (size_t offset = 0; offset < text.length(); offset += blockOptions.blockSize) {
+        std::vector<BlockHeader> headers;
+        std::string block = text.substr(offset, blockOptions.blockSize);
+        std::string framed = Compressor::frameBlocks(block, blockOptions, headers);
+
+        size_t blockOffset = 0;
+        uint64_t fileOffset = writeOffset + added.tellp();
+        for (const BlockHeader& header : headers) {
+            index.push_back({layout.rawSize + offset + blockOffset, fileOffset, header.rawSize});
+            if (options.searchable) {
+                filters.push_back(BlockFilter::build(block.data() + blockOffset, header.rawSize));
+            }
+            blockOffset += header.rawSize;
+            fileOffset += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+        }
+        added << framed;
+    }
+    if (!filters.empty()) {
+        added << Compressor::frameFilters(filters);
+    }
+    if (layout.seekable) {
+        added << Compressor::frameIndex(index);
+    }
+
+    std::string bytes = added.str();
+    {
+        ScopedPhase phase("write");
+        file.clear();
+        file.seekp(writeOffset);
+        file.write(bytes.data(), bytes.size());
+        file.flush();
+    }
+    if (!file) {
+        // Drop whatever part of the new data made it out
+        file.close();
+        std::error_code ec;
+        std::filesystem::resize_file(path, layout.fileSize, ec);
+        throw std::runtime_error("Cannot write to compressed file");
+    }
+
+    if (keepOldIndex) {
+        // The new trailer is durable; now the old index can become a skippable block
+        syncToDisk(path);
+
+        std::ostringstream skip(std::ios::binary);
+        writeValue<uint8_t>(skip, BLOCK_SKIP);
+        writeValue<uint32_t>(skip, 0);
+        writeValue<uint32_t>(skip, static_cast<uint32_t>(layout.fileSize - layout.blocksEnd - Compressor::BLOCK_HEADER_SIZE));
+        writeValue<uint32_t>(skip, 0);   // CRC32C of no bytes
+
+        std::string header = skip.str();
+        file.seekp(layout.blocksEnd);
+        file.write(header.data(), header.size());
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Cannot write to compressed file");
+        }
+    }
+
+    AppendResult result;
+    result.appendedBytes = text.length();
+    result.fileSize = writeOffset + bytes.size();
+    result.reusedTable = layout.haveTree;
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef APPENDER_H
+#define APPENDER_H
+
+#include "Compressor.h"
+#include <string>
+#include <cstdint>
+
+struct AppendResult {
+    uint64_t appendedBytes = 0;     // Uncompressed bytes added
+    uint64_t fileSize = 0;          // Size of the compressed file afterwards
+    bool reusedTable = false;       // An existing block's table was available for reuse
+};
+
+// Adds data to a file written by compress without touching its existing
+// blocks, so the cost follows the size of the new data. New blocks point to
+// the code table of the file's last Huffman or ANS block when that is nearly
+// as small as carrying their own.
+//
+// Seekable files stay seekable. The new blocks and a complete new index are
+// written after the old index, and only once they are on disk is the old
+// index turned into a BLOCK_SKIP block. Until then readers see the old
+// contents, so an interrupted append never leaves a half-updated index.
+//
+// Files without an index have nothing to commit, so their new blocks are
+// written in place at the end. A failed write is truncated away, but a crash
+// mid-write can leave a torn last block; that path is not crash-safe.
+class Appender {
+public:
+    static AppendResult append(const std::string& path, const std::string& text,
+                               const CompressOptions& options = CompressOptions());
+
+private:
+    struct Layout {
+        uint64_t fileSize;
+        uint64_t blocksEnd;         // End of the block list (old index, or end of file)
+        uint64_t rawSize;           // Uncompressed size of the existing data
+        bool seekable;
+        bool haveTree;
+        uint64_t treeOffset;        // Last BLOCK_HUFFMAN or BLOCK_ANS block, directly or via BLOCK_REUSE
+        std::vector<BlockIndexEntry> index;
+    };
+
+    static Layout scan(std::istream& in);
+    static bool treeSource(std::istream& in, uint64_t blockOffset, uint64_t& treeOffset);
+};
+
+#endif // APPENDER_H
@@ -0,0 +1,281 @@
+#include "Archive.h"
+#include "BinaryIO.h"
+#include "Crc32c.h"
+#include "ChunkIndex.h"
+#include <fstream>
+#include <stdexcept>
+#include <deque>
+#include <set>
+#include <algorithm>
+
+const char Archive::MAGIC[4] = {'H', 'F', 'A', '1'};
+const char Archive::TRAILER_MAGIC[4] = {'H', 'F', 'A', 'C'};
+
+namespace {
+
+const size_t TRAILER_SIZE = 2 * sizeof(uint64_t) + sizeof(uint32_t) + 4;
+
+// Name length, raw size, offset, stored size, checksum; the name itself may be empty
+const size_t MIN_CATALOG_ENTRY_SIZE = sizeof(uint16_t) + 3 * sizeof(uint64_t) + sizeof(uint32_t);
+
+bool readMember(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    contents.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Stored member names use forward slashes and no leading directories of absolute paths
+std::string memberName(const std::string& path) {
+    std::string name = path;
+    for (char& ch : name) {
+        if (ch == '\\') ch = '/';
+    }
+    while (!name.empty() && name[0] == '/') name.erase(0, 1);
+    return name;
+}
+
+} // namespace
+
+bool Archive::create(const std::string& archivePath, const std::vector<std::string>& files,
+                     const CompressOptions& options, bool useSharedTable, std::string& error) {
+    // extract finds members by name, so a second one with the same name could never be read
+    std::set<std::string> names;
+    for (const auto& path : files) {
+        if (!names.insert(memberName(path)).second) {
+            error = "Duplicate member name " + memberName(path);
+            return false;
+        }
+    }
+
+    // First pass: one histogram over every member for the shared table
+    HuffmanTree sharedTree;
+    bool haveShared = false;
+    if (useSharedTable && options.lzLevel == 0) {
+        std::unordered_map<char, int> combined;
+        for (const auto& path : files) {
+            std::string contents;
+            if (!readMember(path, contents)) {
+                error = "Cannot open input file " + path;
+                return false;
+            }
+            for (const auto& pair : Compressor::histogram(contents)) {
+                combined[pair.first] += pair.second;
+            }
+        }
+        if (!combined.empty()) {
+            sharedTree.buildTree(combined);
+            haveShared = true;
+        }
+    }
+
+    std::ofstream out(archivePath, std::ios::binary);
+    if (!out) {
+        error = "Cannot create archive " + archivePath;
+        return false;
+    }
+    out.write(MAGIC, sizeof(MAGIC));
+
+    Trailer trailer = {0, 0, 0};
+    if (haveShared) {
+        trailer.sharedTreeOffset = static_cast<uint64_t>(out.tellp());
+        if (!sharedTree.saveTree(out)) {
+            error = "Failed to write shared table";
+            return false;
+        }
+    }
+
+    CompressOptions memberOptions = options;
+    memberOptions.sharedTree = haveShared ? &sharedTree : nullptr;
+
+    // Dedup compares new chunks byte for byte with earlier members, so those stay in memory
+    ChunkIndex chunks;
+    std::deque<std::string> dedupSources;
+    if (options.dedup) {
+        memberOptions.chunkIndex = &chunks;
+    }
+
+    // Second pass: compress and append each member
+    std::vector<ArchiveEntry> catalog;
+    for (const auto& path : files) {
+        std::string contents;
+        if (!readMember(path, contents)) {
+            error = "Cannot open input file " + path;
+            return false;
+        }
+        if (options.dedup) {
+            dedupSources.push_back(std::move(contents));
+        }
+        const std::string& member = options.dedup ? dedupSources.back() : contents;
+
+        std::string compressed = Compressor::compress(member, memberOptions);
+        memberOptions.rawBase += member.length();
+        ArchiveEntry entry;
+        entry.name = memberName(path);
+        entry.rawSize = member.length();
+        entry.offset = static_cast<uint64_t>(out.tellp());
+        entry.storedSize = compressed.length();
+        entry.checksum = crc32c(member);
+        catalog.push_back(entry);
+
+        out.write(compressed.data(), compressed.size());
+    }
+
+    trailer.catalogOffset = static_cast<uint64_t>(out.tellp());
+    trailer.memberCount = static_cast<uint32_t>(catalog.size());
+    for (const auto& entry : catalog) {
+        writeValue<uint16_t>(out, static_cast<uint16_t>(entry.name.length()));
+        out.write(entry.name.data(), entry.name.length());
+        writeValue<uint64_t>(out, entry.rawSize);
+        writeValue<uint64_t>(out, entry.offset);
+        writeValue<uint64_t>(out, entry.storedSize);
+        writeValue<uint32_t>(out, entry.checksum);
+    }
+
+    writeValue<uint64_t>(out, trailer.sharedTreeOffset);
+    writeValue<uint64_t>(out, trailer.catalogOffset);
+    writeValue<uint32_t>(out, trailer.memberCount);
+    out.write(TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+
+    if (!out) {
+        error = "Failed to write archive " + archivePath;
+        return false;
+    }
+    return true;
+}
+
+Archive::Trailer Archive::readTrailer(std::istream& in) {
+    char magic[4];
+    if (!in.seekg(0).read(magic, sizeof(magic)) || std::string(magic, 4) != std::string(MAGIC, 4)) {
+        throw std::runtime_error("Not an archive (bad magic)");
+    }
+
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    if (fileSize < sizeof(MAGIC) + TRAILER_SIZE) {
+        throw std::runtime_error("Truncated archive");
+    }
+
+    in.seekg(fileSize - TRAILER_SIZE);
+    Trailer trailer;
+    trailer.sharedTreeOffset = readValue<uint64_t>(in);
+    trailer.catalogOffset = readValue<uint64_t>(in);
+    trailer.memberCount = readValue<uint32_t>(in);
+    if (!in.read(magic, sizeof(magic)) || std::string(magic, 4) != std::string(TRAILER_MAGIC, 4)) {
+        throw std::runtime_error("Corrupt archive trailer");
+    }
+    if (trailer.catalogOffset > fileSize - TRAILER_SIZE) {
+        throw std::runtime_error("Corrupt archive catalog offset");
+    }
+    // The count sizes the catalog allocation, so it must fit in the bytes before the trailer
+    uint64_t catalogBytes = fileSize - TRAILER_SIZE - trailer.catalogOffset;
+    if (trailer.memberCount > catalogBytes / MIN_CATALOG_ENTRY_SIZE) {
+        throw std::runtime_error("Corrupt archive member count");
+    }
+    return trailer;
+}
+
+std::vector<ArchiveEntry> Archive::list(std::istream& in) {
+    return readCatalog(in, readTrailer(in));
+}
+
+std::vector<ArchiveEntry> Archive::readCatalog(std::istream& in, const Trailer& trailer) {
+    in.seekg(trailer.catalogOffset);
+
+    std::vector<ArchiveEntry> catalog;
+    catalog.reserve(trailer.memberCount);
+    for (uint32_t i = 0; i < trailer.memberCount; ++i) {
+        ArchiveEntry entry;
+        uint16_t nameLength = readValue<uint16_t>(in);
+        entry.name.assign(nameLength, '\0');
+        if (!in.read(&entry.name[0], nameLength)) {
+            throw std::runtime_error("Truncated archive catalog");
+        }
+        entry.rawSize = readValue<uint64_t>(in);
+        entry.offset = readValue<uint64_t>(in);
+        entry.storedSize = readValue<uint64_t>(in);
+        entry.checksum = readValue<uint32_t>(in);
+        // Members lie between the magic and the catalog; checked before storedSize is allocated
+        if (entry.offset < sizeof(MAGIC) || entry.offset > trailer.catalogOffset ||
+            entry.storedSize > trailer.catalogOffset - entry.offset) {
+            throw std::runtime_error("Corrupt archive catalog entry " + entry.name);
+        }
+        catalog.push_back(entry);
+    }
+    return catalog;
+}
+
+std::string Archive::extract(std::istream& in, const std::string& name) {
+    Trailer trailer = readTrailer(in);
+
+    const ArchiveEntry* found = nullptr;
+    std::vector<ArchiveEntry> catalog = readCatalog(in, trailer);
+    for (const auto& entry : catalog) {
+        if (entry.name == name) {
+            found = &entry;
+            break;
+        }
+    }
+    if (!found) {
+        throw std::runtime_error("No member named " + name);
+    }
+
+    HuffmanTree sharedTree;
+    bool haveShared = trailer.sharedTreeOffset != 0;
+    if (haveShared) {
+        in.clear();
+        in.seekg(trailer.sharedTreeOffset);
+        if (!sharedTree.loadTree(in)) {
+            throw std::runtime_error("Invalid shared table");
+        }
+    }
+
+    std::map<size_t, std::string> decoded;
+    return decodeMember(in, catalog, found - catalog.data(), haveShared ? &sharedTree : nullptr, decoded);
+}
+
+const std::string& Archive::decodeMember(std::istream& in, const std::vector<ArchiveEntry>& catalog, size_t member,
+                                         const HuffmanTree* sharedTree, std::map<size_t, std::string>& decoded) {
+    auto cached = decoded.find(member);
+    if (cached != decoded.end()) return cached->second;
+
+    const ArchiveEntry& entry = catalog[member];
+    in.clear();
+    in.seekg(entry.offset);
+    std::string compressed(entry.storedSize, '\0');
+    if (!in.read(&compressed[0], entry.storedSize)) {
+        throw std::runtime_error("Truncated archive member " + entry.name);
+    }
+
+    uint64_t rawBase = 0;
+    for (size_t i = 0; i < member; ++i) {
+        rawBase += catalog[i].rawSize;
+    }
+
+    // Copies of earlier members' chunks, decoding each source member once
+    HistorySource earlier = [&](uint64_t offset, uint64_t length) {
+        std::string bytes;
+        uint64_t start = 0;
+        for (size_t i = 0; i < member && length > 0; ++i) {
+            uint64_t end = start + catalog[i].rawSize;
+            if (offset < end) {
+                const std::string& source = decodeMember(in, catalog, i, sharedTree, decoded);
+                uint64_t count = std::min(length, end - offset);
+                bytes.append(source, offset - start, count);
+                offset += count;
+                length -= count;
+            }
+            start = end;
+        }
+        if (length > 0) {
+            throw std::runtime_error("Copy block refers past earlier members");
+        }
+        return bytes;
+    };
+
+    std::string contents = Compressor::decompress(compressed, sharedTree, earlier, rawBase);
+    if (contents.length() != entry.rawSize || crc32c(contents) != entry.checksum) {
+        throw std::runtime_error("Checksum mismatch in member " + entry.name);
+    }
+    return decoded[member] = std::move(contents);
+}
@@ -0,0 +1,55 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "Compressor.h"
+#include "HuffmanTree.h"
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include <map>
+
+// Many members in one file:
+//   magic, [shared tree], member containers..., catalog, trailer
+// The trailer locates the shared tree and the catalog, so listing or
+// extracting one member never reads the others.
+struct ArchiveEntry {
+    std::string name;
+    uint64_t rawSize;
+    uint64_t offset;        // Start of the member's container in the archive
+    uint64_t storedSize;
+    uint32_t checksum;      // CRC32C of the whole uncompressed member
+};
+
+class Archive {
+public:
+    static const char MAGIC[4];
+    static const char TRAILER_MAGIC[4];
+
+    // Builds the archive from files on disk. With useSharedTable, one tree is
+    // built from all members and each block picks it when cheaper than its own.
+    // With options.dedup, chunks repeated from earlier members are stored as
+    // references to them; extracting such a member also decodes its sources.
+    static bool create(const std::string& archivePath, const std::vector<std::string>& files,
+                       const CompressOptions& options, bool useSharedTable, std::string& error);
+
+    static std::vector<ArchiveEntry> list(std::istream& in);
+    static std::string extract(std::istream& in, const std::string& name);
+
+private:
+    struct Trailer {
+        uint64_t sharedTreeOffset;   // 0 when there is no shared tree
+        uint64_t catalogOffset;
+        uint32_t memberCount;
+    };
+
+    static Trailer readTrailer(std::istream& in);
+    static std::vector<ArchiveEntry> readCatalog(std::istream& in, const Trailer& trailer);
+
+    // Members are numbered in catalog order, which is also the order of the
+    // dedup offset space; decoded maps member number to contents
+    static const std::string& decodeMember(std::istream& in, const std::vector<ArchiveEntry>& catalog, size_t member,
+                                           const HuffmanTree* sharedTree, std::map<size_t, std::string>& decoded);
+};
+
+#endif // ARCHIVE_H
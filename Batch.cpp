@@ -0,0 +1,182 @@
+#include "Batch.h"
+#include "ThreadPool.h"
+#include "Stats.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string COMPRESSED_SUFFIX = ".hfz";
+
+bool readWholeFile(const std::string& path, std::string& contents) {
+    ScopedPhase phase("read");
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    contents.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool writeWholeFile(const std::string& path, const std::string& contents) {
+    ScopedPhase phase("write");
+    std::error_code ec;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) fs::create_directories(parent, ec);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.write(contents.data(), contents.size());
+    return static_cast<bool>(file);
+}
+
+// The path of a list entry below the output directory: the root of an
+// absolute path and any ".." are dropped, so no output lands outside it
+std::string relativeName(const std::string& path) {
+    fs::path kept;
+    for (const fs::path& part : fs::path(path).lexically_normal().relative_path()) {
+        if (!part.empty() && part != "." && part != "..") kept /= part;
+    }
+    return kept.string();
+}
+
+// Two jobs writing one output would race on it
+bool checkDistinctOutputs(const std::vector<BatchJob>& jobs, std::string& error) {
+    std::map<std::string, const BatchJob*> outputs;
+    for (const BatchJob& job : jobs) {
+        auto inserted = outputs.emplace(fs::path(job.output).lexically_normal().string(), &job);
+        if (!inserted.second) {
+            error = "Inputs " + inserted.first->second->input + " and " + job.input + " both map to " + job.output;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::string Batch::outputPathFor(BatchMode mode, const std::string& relative, const std::string& outputDir) {
+    std::string name = relative;
+    if (mode == BATCH_COMPRESS) {
+        name += COMPRESSED_SUFFIX;
+    } else if (name.size() > COMPRESSED_SUFFIX.size()
+               && name.compare(name.size() - COMPRESSED_SUFFIX.size(), COMPRESSED_SUFFIX.size(), COMPRESSED_SUFFIX) == 0) {
+        name.erase(name.size() - COMPRESSED_SUFFIX.size());
+    } else {
+        name += ".out";
+    }
+    return (fs::path(outputDir) / name).string();
+}
+
+bool Batch::collectJobs(BatchMode mode, const std::string& source, const std::string& outputDir,
+                        std::vector<BatchJob>& jobs, std::string& error) {
+    std::error_code ec;
+    jobs.clear();
+
+    auto addJob = [&](const std::string& input, const std::string& relative) {
+        uint64_t size = fs::file_size(input, ec);
+        if (ec) size = 0;
+        jobs.push_back({input, outputPathFor(mode, relative, outputDir), size});
+    };
+
+    if (source != "-" && fs::is_directory(source, ec)) {
+        for (fs::recursive_directory_iterator it(source, ec), end; it != end; it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec)) {
+                addJob(it->path().string(), fs::relative(it->path(), source, ec).string());
+            }
+        }
+        if (ec) {
+            error = "Cannot read directory " + source + ": " + ec.message();
+            return false;
+        }
+        return checkDistinctOutputs(jobs, error);
+    }
+
+    std::ifstream listFile;
+    if (source != "-") {
+        listFile.open(source);
+        if (!listFile) {
+            error = "Cannot open file list " + source;
+            return false;
+        }
+    }
+    std::istream& list = source == "-" ? std::cin : listFile;
+
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        std::string relative = relativeName(line);
+        if (relative.empty()) {
+            error = "No file name in list entry " + line;
+            return false;
+        }
+        addJob(line, relative);
+    }
+    return checkDistinctOutputs(jobs, error);
+}
+
+BatchSummary Batch::run(BatchMode mode, std::vector<BatchJob> jobs, const CompressOptions& options,
+                        size_t threadCount, std::ostream& report) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Largest first, so the big files start early and the small ones fill in around them
+    std::stable_sort(jobs.begin(), jobs.end(), [](const BatchJob& a, const BatchJob& b) {
+        return a.inputBytes > b.inputBytes;
+    });
+
+    BatchSummary summary;
+    summary.files = jobs.size();
+    std::mutex reportMutex;
+
+    {
+        ThreadPool pool(threadCount);
+        for (const BatchJob& job : jobs) {
+            pool.submit([&, job] {
+                auto jobStart = std::chrono::steady_clock::now();
+                std::string input, output, failure;
+
+                try {
+                    if (!readWholeFile(job.input, input)) {
+                        failure = "Cannot open input file";
+                    } else {
+                        output = mode == BATCH_COMPRESS ? Compressor::compress(input, options)
+                                                        : Compressor::decompress(input);
+                        if (!writeWholeFile(job.output, output)) {
+                            failure = "Cannot create output file";
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    failure = e.what();
+                }
+
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jobStart).count();
+
+                std::lock_guard<std::mutex> lock(reportMutex);
+                if (failure.empty()) {
+                    uint64_t raw = mode == BATCH_COMPRESS ? input.size() : output.size();
+                    uint64_t packed = mode == BATCH_COMPRESS ? output.size() : input.size();
+                    summary.inputBytes += input.size();
+                    summary.outputBytes += output.size();
+                    summary.uncompressedBytes += raw;
+                    Stats::global().addBytes(raw, packed);
+                    report << "FILE:OK:" << job.input << ":" << input.size() << ":" << output.size()
+                           << ":" << static_cast<uint64_t>(ms) << "ms" << std::endl;
+                } else {
+                    summary.failed++;
+                    report << "FILE:ERROR:" << job.input << ":" << failure << std::endl;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summary;
+}
@@ -0,0 +1,48 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "Compressor.h"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+enum BatchMode {
+    BATCH_COMPRESS,
+    BATCH_DECOMPRESS
+};
+
+struct BatchJob {
+    std::string input;
+    std::string output;
+    uint64_t inputBytes;
+};
+
+struct BatchSummary {
+    size_t files = 0;
+    size_t failed = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    uint64_t uncompressedBytes = 0;   // Throughput basis for either direction
+    double seconds = 0.0;
+};
+
+// Compresses or decompresses many files in one process on a work-stealing pool
+class Batch {
+public:
+    // Source is a directory (walked recursively), a file listing one path per
+    // line, or "-" for the same listing on stdin. Output paths mirror the
+    // input's relative path under outputDir; listed paths lose their root and
+    // any "..". Fails if two inputs would write the same output.
+    static bool collectJobs(BatchMode mode, const std::string& source, const std::string& outputDir,
+                            std::vector<BatchJob>& jobs, std::string& error);
+
+    // Writes one FILE: line per job as it finishes, then returns the totals
+    static BatchSummary run(BatchMode mode, std::vector<BatchJob> jobs, const CompressOptions& options,
+                            size_t threadCount, std::ostream& report);
+
+private:
+    static std::string outputPathFor(BatchMode mode, const std::string& relative, const std::string& outputDir);
+};
+
+#endif // BATCH_H
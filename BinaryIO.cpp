@@ -0,0 +1,82 @@
+#include "BinaryIO.h"
+#include <filesystem>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::string packBits(const std::string& bits) {
+    std::string bytes((bits.length() + 7) / 8, '\0');
+
+    for (size_t i = 0; i < bits.length(); ++i) {
+        if (bits[i] == '1') {
+            bytes[i / 8] |= static_cast<char>(0x80 >> (i % 8));
+        }
+    }
+
+    return bytes;
+}
+
+std::string unpackBits(const std::string& bytes, size_t bitCount) {
+    if (bitCount > bytes.length() * 8) {
+        throw std::runtime_error("Packed bit count exceeds payload size");
+    }
+
+    std::string bits(bitCount, '0');
+    for (size_t i = 0; i < bitCount; ++i) {
+        if (static_cast<unsigned char>(bytes[i / 8]) & (0x80 >> (i % 8))) {
+            bits[i] = '1';
+        }
+    }
+
+    return bits;
+}
+
+void appendBits(std::string& bits, uint32_t value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        bits += ((value >> i) & 1) ? '1' : '0';
+    }
+}
+
+uint32_t readBits(const std::string& bits, int& pos, int count) {
+    if (pos + count > static_cast<int>(bits.length())) {
+        throw std::runtime_error("Incomplete encoded string");
+    }
+
+    uint32_t value = 0;
+    for (int i = 0; i < count; ++i) {
+        value = (value << 1) | (bits[pos++] == '1' ? 1u : 0u);
+    }
+    return value;
+}
+
+void syncToDisk(const std::string& path) {
+#if !defined(_WIN32)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path + " to sync it");
+    }
+    int status = fsync(fd);
+    close(fd);
+    if (status != 0) {
+        throw std::runtime_error("Cannot sync " + path + " to disk");
+    }
+#else
+    (void)path;
+#endif
+}
+
+void syncParentDirectory(const std::string& path) {
+#if !defined(_WIN32)
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <cstdint>
+
+// Fixed-width values are written in host byte order, like the tree file fields
+template <typename T>
+void writeValue(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::istream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("Unexpected end of compressed data");
+    }
+    return value;
+}
+
+// Pack a '0'/'1' bit string (as produced by HuffmanTree::encode) into bytes, MSB first
+std::string packBits(const std::string& bits);
+
+// Expand packed bytes back into a '0'/'1' bit string of bitCount bits
+std::string unpackBits(const std::string& bytes, size_t bitCount);
+
+// Append the low `count` bits of value to a '0'/'1' bit string, MSB first
+void appendBits(std::string& bits, uint32_t value, int count);
+
+// Read `count` raw bits from a '0'/'1' bit string, advancing pos
+uint32_t readBits(const std::string& bits, int& pos, int count);
+
+// Flushes the file's data to stable storage so later writes cannot overtake it;
+// throws std::runtime_error if it cannot
+void syncToDisk(const std::string& path);
+
+// Flushes the directory holding path, so a rename into it survives a crash
+void syncParentDirectory(const std::string& path);
+
+#endif // BINARYIO_H
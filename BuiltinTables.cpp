@@ -0,0 +1,206 @@
+#include "BuiltinTables.h"
+#include "BinaryIO.h"
+#include <stdexcept>
+
+namespace {
+
+// Representative samples; the tables are Huffman codes over their byte
+// counts, computed by the compiler
+constexpr char ENGLISH_SAMPLE[] =
+    "The quick brown fox jumps over the lazy dog. This is a short note to let you know that the meeting "
+    "has been moved to Thursday afternoon, because several of us will be away on Wednesday. Please bring "
+    "the figures from last month and any questions you would like to discuss with the rest of the team. "
+    "If you cannot attend, send your comments to me before the end of the day and I will make sure they "
+    "are read out. We are also looking for someone to help with the new project, which should start in "
+    "the spring. It is not a large job, but it does need a person who can work on their own and who has "
+    "some experience with customers. Thank you again for all of your hard work this year. I know it has "
+    "not always been easy, and I am grateful for the time and care that everyone has put in. Have a good "
+    "weekend, and I will see you all on Monday morning. What do you think of the plan? Let me know if it "
+    "works for you, or if there is anything we should change. When it rains, the river rises quickly and "
+    "the old bridge is closed; most people then take the longer road around the hill to reach the town.";
+
+constexpr char JSON_SAMPLE[] =
+    "{\"id\":1024,\"name\":\"Alice Smith\",\"email\":\"alice@example.com\",\"active\":true,\"roles\":[\"admin\","
+    "\"editor\"],\"created_at\":\"2024-03-18T09:15:22Z\",\"score\":87.5,\"tags\":[],\"address\":{\"street\":"
+    "\"12 High Street\",\"city\":\"London\",\"zip\":\"N1 9GU\"}}\n"
+    "{\"id\":1025,\"name\":\"Bob Jones\",\"email\":\"bob@example.org\",\"active\":false,\"roles\":[\"viewer\"],"
+    "\"created_at\":\"2024-03-19T14:02:51Z\",\"score\":null,\"tags\":[\"trial\",\"beta\"],\"address\":null}\n"
+    "{\n  \"status\": \"ok\",\n  \"count\": 3,\n  \"items\": [\n    {\"type\": \"order\", \"value\": 19.99, "
+    "\"currency\": \"USD\"},\n    {\"type\": \"refund\", \"value\": -5.00, \"currency\": \"EUR\"},\n    "
+    "{\"type\": \"order\", \"value\": 240, \"currency\": \"GBP\"}\n  ],\n  \"next\": \"/api/v1/orders?page=2\","
+    "\n  \"error\": null\n}\n"
+    "{\"event\":\"click\",\"user_id\":\"u_83f2a1\",\"session\":\"9c4e7d10-5b2f-4a8e-b6d3-0f1e2a3b4c5d\","
+    "\"path\":\"/products/42\",\"duration_ms\":350,\"meta\":{\"browser\":\"Firefox\",\"mobile\":false}}\n";
+
+constexpr char LOG_SAMPLE[] =
+    "2024-05-02 08:14:03,512 INFO  [main] server.Http - Listening on 0.0.0.0:8080\n"
+    "2024-05-02 08:14:07,019 DEBUG [worker-3] db.Pool - Acquired connection id=17 wait=2ms\n"
+    "2024-05-02 08:14:07,021 INFO  [worker-3] api.Orders - GET /api/orders/5821 200 14ms\n"
+    "2024-05-02 08:14:09,884 WARN  [worker-1] cache.Redis - Slow response 412ms key=session:a91f\n"
+    "2024-05-02 08:14:10,002 ERROR [worker-7] api.Payments - POST /api/payments 500 231ms: "
+    "java.net.SocketTimeoutException: Read timed out\n"
+    "May  2 08:14:11 web01 sshd[2231]: Accepted publickey for deploy from 10.0.4.21 port 51522 ssh2\n"
+    "May  2 08:14:12 web01 kernel: [123456.789012] eth0: link up, 1000 Mbps, full duplex\n"
+    "127.0.0.1 - - [02/May/2024:08:14:13 +0000] \"GET /index.html HTTP/1.1\" 200 5120 \"-\" "
+    "\"Mozilla/5.0 (X11; Linux x86_64)\"\n"
+    "10.0.3.8 - alice [02/May/2024:08:14:15 +0000] \"POST /login HTTP/1.1\" 302 0 \"https://example.com/\" "
+    "\"curl/8.1.2\"\n"
+    "2024-05-02T08:14:16.204Z level=info msg=\"request completed\" method=GET path=/health status=200 "
+    "latency=0.8ms\n"
+    "2024-05-02T08:14:18.937Z level=error msg=\"upstream unavailable\" service=billing retries=3\n";
+
+// Sample bytes outweigh the floor of 1 given to every other byte value
+constexpr uint64_t SAMPLE_WEIGHT = 16;
+
+constexpr StaticCode buildStaticCode(const char* sample, size_t length) {
+    StaticCode code{};
+
+    // Plain O(n^2) Huffman construction over 256 leaves; nodes 256.. are merges
+    uint64_t weight[511] = {};
+    int parent[511] = {};
+    bool merged[511] = {};
+    for (int i = 0; i < 256; ++i) weight[i] = 1;
+    for (size_t i = 0; i < length; ++i) weight[static_cast<unsigned char>(sample[i])] += SAMPLE_WEIGHT;
+
+    for (int next = 256; next < 511; ++next) {
+        int a = -1, b = -1;
+        for (int i = 0; i < next; ++i) {
+            if (merged[i]) continue;
+            if (a < 0 || weight[i] < weight[a]) {
+                b = a;
+                a = i;
+            } else if (b < 0 || weight[i] < weight[b]) {
+                b = i;
+            }
+        }
+        merged[a] = merged[b] = true;
+        weight[next] = weight[a] + weight[b];
+        parent[a] = parent[b] = next;
+    }
+
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        int depth = 0;
+        for (int node = symbol; node != 510; node = parent[node]) ++depth;
+        code.lengths[symbol] = static_cast<uint8_t>(depth);
+        code.count[depth]++;
+    }
+
+    // Canonical codes, assigned in (length, byte value) order as in Deflate
+    uint32_t nextCode[StaticCode::MAX_BITS + 1] = {};
+    uint32_t value = 0;
+    for (int bits = 1; bits <= StaticCode::MAX_BITS; ++bits) {
+        value = (value + code.count[bits - 1]) << 1;
+        nextCode[bits] = value;
+    }
+
+    int position = 0;
+    for (int bits = 1; bits <= StaticCode::MAX_BITS; ++bits) {
+        for (int symbol = 0; symbol < 256; ++symbol) {
+            if (code.lengths[symbol] != bits) continue;
+            code.codes[symbol] = nextCode[bits]++;
+            code.symbols[position++] = static_cast<uint8_t>(symbol);
+        }
+    }
+    return code;
+}
+
+constexpr int maxLength(const StaticCode& code) {
+    int longest = 0;
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        if (code.lengths[symbol] > longest) longest = code.lengths[symbol];
+    }
+    return longest;
+}
+
+constexpr StaticCode ENGLISH_CODE = buildStaticCode(ENGLISH_SAMPLE, sizeof(ENGLISH_SAMPLE) - 1);
+constexpr StaticCode JSON_CODE = buildStaticCode(JSON_SAMPLE, sizeof(JSON_SAMPLE) - 1);
+constexpr StaticCode LOG_CODE = buildStaticCode(LOG_SAMPLE, sizeof(LOG_SAMPLE) - 1);
+
+static_assert(maxLength(ENGLISH_CODE) <= StaticCode::MAX_BITS, "English code too long");
+static_assert(maxLength(JSON_CODE) <= StaticCode::MAX_BITS, "JSON code too long");
+static_assert(maxLength(LOG_CODE) <= StaticCode::MAX_BITS, "Log code too long");
+static_assert(ENGLISH_CODE.lengths[' '] < ENGLISH_CODE.lengths['Z'], "English table favours common bytes");
+
+} // namespace
+
+const BuiltinTable& BuiltinTable::get(BuiltinTableId id) {
+    static const BuiltinTable tables[BUILTIN_TABLE_COUNT] = {
+        BuiltinTable(TABLE_ENGLISH, "english", ENGLISH_CODE),
+        BuiltinTable(TABLE_JSON, "json", JSON_CODE),
+        BuiltinTable(TABLE_LOG, "log", LOG_CODE)
+    };
+    if (id >= BUILTIN_TABLE_COUNT) {
+        throw std::runtime_error("Unknown built-in table " + std::to_string(id));
+    }
+    return tables[id];
+}
+
+const BuiltinTable* BuiltinTable::find(const std::string& name) {
+    for (int id = 0; id < BUILTIN_TABLE_COUNT; ++id) {
+        const BuiltinTable& table = get(static_cast<BuiltinTableId>(id));
+        if (name == table.name()) return &table;
+    }
+    return nullptr;
+}
+
+const BuiltinTable& BuiltinTable::best(const std::unordered_map<char, int>& freqMap, uint64_t& bits) {
+    const BuiltinTable* chosen = &get(TABLE_ENGLISH);
+    bits = chosen->encodedBits(freqMap);
+    for (int id = 1; id < BUILTIN_TABLE_COUNT; ++id) {
+        const BuiltinTable& table = get(static_cast<BuiltinTableId>(id));
+        uint64_t candidate = table.encodedBits(freqMap);
+        if (candidate < bits) {
+            bits = candidate;
+            chosen = &table;
+        }
+    }
+    return *chosen;
+}
+
+uint64_t BuiltinTable::encodedBits(const std::unordered_map<char, int>& freqMap) const {
+    uint64_t bits = 0;
+    for (const auto& pair : freqMap) {
+        bits += static_cast<uint64_t>(pair.second) * code.lengths[static_cast<unsigned char>(pair.first)];
+    }
+    return bits;
+}
+
+std::string BuiltinTable::encode(const std::string& text) const {
+    std::string bits;
+    for (char ch : text) {
+        unsigned char symbol = static_cast<unsigned char>(ch);
+        appendBits(bits, code.codes[symbol], code.lengths[symbol]);
+    }
+    return bits;
+}
+
+std::string BuiltinTable::decode(const std::string& bits) const {
+    std::string text;
+    size_t pos = 0;
+
+    // Canonical decode: codes of each length are consecutive integers, so one
+    // comparison per length replaces a tree walk
+    while (pos < bits.length()) {
+        uint32_t value = 0, first = 0;
+        int index = 0;
+        int length = 1;
+        for (; length <= StaticCode::MAX_BITS; ++length) {
+            if (pos >= bits.length()) {
+                throw std::runtime_error("Incomplete encoded string");
+            }
+            value |= bits[pos++] == '1' ? 1 : 0;
+            uint32_t count = code.count[length];
+            if (value - first < count) {
+                text += static_cast<char>(code.symbols[index + (value - first)]);
+                break;
+            }
+            index += count;
+            first = (first + count) << 1;
+            value <<= 1;
+        }
+        if (length > StaticCode::MAX_BITS) {
+            throw std::runtime_error("Invalid code in encoded string");
+        }
+    }
+    return text;
+}
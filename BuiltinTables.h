@@ -0,0 +1,59 @@
+#ifndef BUILTINTABLES_H
+#define BUILTINTABLES_H
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <array>
+
+// Canonical prefix codes fixed at compile time for common content. Using one
+// needs no tree build and no stored tree, which dominates the cost of coding
+// short inputs. Every byte value has a code, so any input can be encoded.
+enum BuiltinTableId : uint8_t {
+    TABLE_ENGLISH = 0,
+    TABLE_JSON = 1,
+    TABLE_LOG = 2,
+    BUILTIN_TABLE_COUNT = 3
+};
+
+struct StaticCode {
+    static const int MAX_BITS = 24;
+
+    std::array<uint8_t, 256> lengths;
+    std::array<uint32_t, 256> codes;
+    std::array<uint16_t, MAX_BITS + 1> count;   // Codes per length
+    std::array<uint8_t, 256> symbols;           // Ordered by (length, byte value)
+};
+
+class BuiltinTable {
+public:
+    static const BuiltinTable& get(BuiltinTableId id);
+
+    // Looks a table up by name ("english", "json", "log"); null if unknown
+    static const BuiltinTable* find(const std::string& name);
+
+    // The table coding freqMap in the fewest bits
+    static const BuiltinTable& best(const std::unordered_map<char, int>& freqMap, uint64_t& bits);
+
+    BuiltinTableId id() const { return tableId; }
+    const char* name() const { return tableName; }
+
+    uint64_t encodedBits(const std::unordered_map<char, int>& freqMap) const;
+
+    uint32_t codeOf(unsigned char symbol) const { return code.codes[symbol]; }
+    int lengthOf(unsigned char symbol) const { return code.lengths[symbol]; }
+
+    // Same '0'/'1' bit string format as HuffmanTree::encode/decode
+    std::string encode(const std::string& text) const;
+    std::string decode(const std::string& bits) const;
+
+private:
+    BuiltinTable(BuiltinTableId id, const char* name, const StaticCode& code)
+        : tableId(id), tableName(name), code(code) {}
+
+    BuiltinTableId tableId;
+    const char* tableName;
+    const StaticCode& code;
+};
+
+#endif // BUILTINTABLES_H
@@ -0,0 +1,83 @@
+#include "ChunkIndex.h"
+#include "Crc32c.h"
+#include <array>
+#include <cstring>
+
+namespace {
+
+// Per-byte random values for the gear hash, fixed at compile time (splitmix64)
+constexpr std::array<uint64_t, 256> makeGearTable() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < table.size(); ++i) {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        table[i] = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr std::array<uint64_t, 256> GEAR = makeGearTable();
+
+// The top bits of the gear hash see the most history, so test those
+constexpr uint64_t boundaryMask(size_t average) {
+    int bits = 0;
+    while ((static_cast<size_t>(1) << bits) < average) ++bits;
+    return ((static_cast<uint64_t>(1) << bits) - 1) << (64 - bits);
+}
+
+} // namespace
+
+std::vector<size_t> ChunkIndex::chunk(const char* data, size_t length) {
+    return chunk(data, length, MIN_CHUNK, AVERAGE_CHUNK, MAX_CHUNK);
+}
+
+std::vector<size_t> ChunkIndex::chunk(const char* data, size_t length, size_t minChunk, size_t averageChunk, size_t maxChunk) {
+    const uint64_t mask = boundaryMask(averageChunk);
+    std::vector<size_t> ends;
+    size_t start = 0;
+
+    while (start < length) {
+        size_t limit = length - start < maxChunk ? length : start + maxChunk;
+        size_t end = limit;
+
+        // Bytes before minChunk cannot end a chunk, so they are not hashed
+        uint64_t hash = 0;
+        for (size_t i = start + minChunk; i < limit; ++i) {
+            hash = (hash << 1) + GEAR[static_cast<unsigned char>(data[i])];
+            if ((hash & mask) == 0) {
+                end = i + 1;
+                break;
+            }
+        }
+
+        ends.push_back(end);
+        start = end;
+    }
+    return ends;
+}
+
+uint64_t ChunkIndex::fingerprint(const char* data, size_t length) {
+    // Collisions only cost a comparison, so a fast checksum is enough
+    return (static_cast<uint64_t>(length) << 32) | crc32c(data, length);
+}
+
+bool ChunkIndex::find(const char* data, size_t length, uint64_t& rawOffset) const {
+    auto it = entries.find(fingerprint(data, length));
+    if (it == entries.end()) return false;
+
+    for (const Entry& entry : it->second) {
+        if (entry.length == length && std::memcmp(entry.data, data, length) == 0) {
+            rawOffset = entry.rawOffset;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChunkIndex::add(const char* data, size_t length, uint64_t rawOffset) {
+    entries[fingerprint(data, length)].push_back({data, static_cast<uint32_t>(length), rawOffset});
+    chunkCount++;
+}
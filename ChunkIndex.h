@@ -0,0 +1,47 @@
+#ifndef CHUNKINDEX_H
+#define CHUNKINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Content-defined chunking plus a fingerprint index for deduplication.
+// Boundaries come from a gear rolling hash over the bytes themselves, so an
+// insertion early in a file only changes the chunks around it and the rest
+// still match their earlier copies.
+class ChunkIndex {
+public:
+    static const size_t MIN_CHUNK = 2 * 1024;
+    static const size_t AVERAGE_CHUNK = 8 * 1024;   // Must be a power of two
+    static const size_t MAX_CHUNK = 64 * 1024;
+
+    // End offsets of the chunks covering data; the last one is always length
+    static std::vector<size_t> chunk(const char* data, size_t length);
+
+    // The same with other chunk sizes; averageChunk must be a power of two
+    static std::vector<size_t> chunk(const char* data, size_t length, size_t minChunk, size_t averageChunk, size_t maxChunk);
+
+    // Earlier chunk with exactly these bytes (compared, not just hashed)
+    bool find(const char* data, size_t length, uint64_t& rawOffset) const;
+
+    // data must stay valid for as long as the index is used
+    void add(const char* data, size_t length, uint64_t rawOffset);
+
+    size_t size() const { return chunkCount; }
+
+private:
+    struct Entry {
+        const char* data;
+        uint32_t length;
+        uint64_t rawOffset;
+    };
+
+    static uint64_t fingerprint(const char* data, size_t length);
+
+    std::unordered_map<uint64_t, std::vector<Entry>> entries;
+    size_t chunkCount = 0;
+};
+
+#endif // CHUNKINDEX_H
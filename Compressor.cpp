@@ -0,0 +1,929 @@
+#include "Compressor.h"
+#include "HuffmanTree.h"
+#include "BuiltinTables.h"
+#include "ChunkIndex.h"
+#include "LZ77.h"
+#include "WordCoder.h"
+#include "AnsCoder.h"
+#include "Search.h"
+#include "BinaryIO.h"
+#include "Crc32c.h"
+#include "Stats.h"
+#include "Trace.h"
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <array>
+#include <functional>
+
+const char Compressor::MAGIC[4] = {'H', 'F', 'Z', '1'};
+const char Compressor::INDEX_MAGIC[4] = {'H', 'F', 'Z', 'X'};
+
+// Every level keeps 1 MB blocks. At -1, 4 MB and 16 MB blocks were no faster
+// on 20 MB of JSON (35 ms vs 36 and 46 ms) and coded prose larger; the
+// higher levels already split blocks where their statistics change.
+const Compressor::LevelConfig Compressor::LEVELS[Compressor::MAX_LEVEL + 1] = {
+    {0, 0, 0, false, false, false},
+    {1 << 20, 4, 0, false, false, false},
+    {1 << 20, 2, 0, false, false, false},
+    {1 << 20, 0, 0, false, false, false},
+    {1 << 20, 0, 64 << 10, false, false, false},
+    {1 << 20, 0, 32 << 10, false, false, false},
+    {1 << 20, 0, 16 << 10, false, true, false},
+    {1 << 20, 0, 16 << 10, false, true, true},
+    {1 << 20, 0, 8 << 10, false, true, true},
+    {1 << 20, 0, 8 << 10, true, true, true}
+};
+
+namespace {
+
+const size_t INDEX_ENTRY_SIZE = 2 * sizeof(uint64_t) + sizeof(uint32_t);
+const size_t INDEX_TRAILER_SIZE = sizeof(uint32_t) + 4;
+
+// Codes as integers, so a block is packed straight into bytes (the packBits
+// layout) without building a '0'/'1' string first
+struct SymbolCodes {
+    uint32_t code[256];
+    uint8_t length[256];
+};
+
+// False if some code is too long for the 32-bit fast path
+bool symbolCodes(const HuffmanTree& tree, SymbolCodes& table) {
+    std::memset(&table, 0, sizeof(table));
+    for (const auto& pair : tree.getCodes()) {
+        if (pair.second.length() > 32) return false;
+        uint32_t code = 0;
+        for (char bit : pair.second) code = (code << 1) | (bit == '1' ? 1u : 0u);
+        unsigned char symbol = static_cast<unsigned char>(pair.first);
+        table.code[symbol] = code;
+        table.length[symbol] = static_cast<uint8_t>(pair.second.length());
+    }
+    return true;
+}
+
+void symbolCodes(const BuiltinTable& builtin, SymbolCodes& table) {
+    for (int symbol = 0; symbol < 256; ++symbol) {
+        table.code[symbol] = builtin.codeOf(static_cast<unsigned char>(symbol));
+        table.length[symbol] = static_cast<uint8_t>(builtin.lengthOf(static_cast<unsigned char>(symbol)));
+    }
+}
+
+// Writes the bit count and the packed codes of text
+void writePacked(std::ostream& out, const std::string& text, const SymbolCodes& table) {
+    ScopedPhase phase("encode");
+    std::string packed;
+    packed.reserve(text.length() / 2);
+    uint64_t accumulator = 0, bitCount = 0;
+    int pending = 0;
+    for (char ch : text) {
+        unsigned char symbol = static_cast<unsigned char>(ch);
+        accumulator = (accumulator << table.length[symbol]) | table.code[symbol];
+        pending += table.length[symbol];
+        bitCount += table.length[symbol];
+        while (pending >= 8) {
+            pending -= 8;
+            packed.push_back(static_cast<char>(accumulator >> pending));
+        }
+    }
+    if (pending > 0) {
+        packed.push_back(static_cast<char>(accumulator << (8 - pending)));
+    }
+    writeValue<uint64_t>(out, bitCount);
+    out << packed;
+}
+
+void writeCoded(std::ostream& out, const std::string& text, const HuffmanTree& tree) {
+    SymbolCodes table;
+    if (symbolCodes(tree, table)) {
+        writePacked(out, text, table);
+        return;
+    }
+    std::string bits = tree.encode(text);
+    writeValue<uint64_t>(out, bits.length());
+    out << packBits(bits);
+}
+
+} // namespace
+
+void Compressor::applyLevel(CompressOptions& options, int level) {
+    if (level < MIN_LEVEL || level > MAX_LEVEL) {
+        throw std::invalid_argument("Compression level must be between 1 and 9");
+    }
+    const LevelConfig& config = LEVELS[level];
+    options.blockSize = config.blockSize;
+    options.sampleShift = config.sampleShift;
+    options.splitSize = config.splitSize;
+    options.optimalSplit = config.optimalSplit;
+    options.words = config.words;
+    options.optimalCodes = config.optimalCodes;
+}
+
+bool Compressor::isCompressed(const std::string& data) {
+    return data.length() >= sizeof(MAGIC) && data.compare(0, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void Compressor::writeBlock(std::ostream& out, const BlockHeader& header, const std::string& payload) {
+    writeValue<uint8_t>(out, header.mode);
+    writeValue<uint32_t>(out, header.rawSize);
+    writeValue<uint32_t>(out, header.payloadSize);
+    writeValue<uint32_t>(out, header.checksum);
+    out << payload;
+}
+
+bool Compressor::readBlockHeader(std::istream& in, BlockHeader& header) {
+    int next = in.peek();
+    if (next == std::char_traits<char>::eof() || next == BLOCK_INDEX) {
+        return false;
+    }
+
+    header.mode = static_cast<BlockMode>(readValue<uint8_t>(in));
+    header.rawSize = readValue<uint32_t>(in);
+    header.payloadSize = readValue<uint32_t>(in);
+    header.checksum = readValue<uint32_t>(in);
+    return true;
+}
+
+bool Compressor::readBlock(std::istream& in, BlockHeader& header, std::string& payload) {
+    if (!readBlockHeader(in, header)) {
+        return false;
+    }
+
+    payload.assign(header.payloadSize, '\0');
+    if (!in.read(&payload[0], header.payloadSize)) {
+        throw std::runtime_error("Truncated block payload");
+    }
+    return true;
+}
+
+std::string Compressor::decodeVerified(const BlockHeader& header, const std::string& payload, size_t blockIndex,
+                                       const DecodeContext& context) {
+    TRACE_SCOPE_ARG("decode_block", "block", blockIndex);
+
+    // Checked while the decoded block is still hot in cache
+    std::string block = decodeBlock(header, payload, context);
+    if (crc32c(block) != header.checksum) {
+        throw std::runtime_error("Checksum mismatch in block " + std::to_string(blockIndex));
+    }
+    return block;
+}
+
+std::string Compressor::frameBlock(const std::string& block, const CompressOptions& options, BlockHeader& header) {
+    TRACE_SCOPE_ARG("encode_block", "raw_bytes", block.length());
+    std::string payload = encodeBlock(block, options, header.mode);
+    if (header.mode != BLOCK_STORED && payload.length() >= block.length()) {
+        // Only possible when the coding choice was made from sampled statistics
+        header.mode = BLOCK_STORED;
+        payload = block;
+    }
+    header.rawSize = static_cast<uint32_t>(block.length());
+    header.payloadSize = static_cast<uint32_t>(payload.length());
+    header.checksum = crc32c(block);
+    Stats::global().increment(header.mode == BLOCK_STORED ? "stored_blocks" : "coded_blocks");
+
+    std::ostringstream out(std::ios::binary);
+    writeBlock(out, header, payload);
+    return out.str();
+}
+
+std::string Compressor::frameBlocks(const std::string& block, const CompressOptions& options,
+                                    std::vector<BlockHeader>& headers) {
+    auto frameSplit = [&](const std::vector<size_t>& lengths, std::vector<BlockHeader>& splitHeaders) {
+        std::string framed;
+        size_t offset = 0;
+        for (size_t length : lengths) {
+            BlockHeader header;
+            framed += frameBlock(block.substr(offset, length), options, header);
+            splitHeaders.push_back(header);
+            offset += length;
+        }
+        return framed;
+    };
+
+    headers.clear();
+    std::string framed = frameSplit(splitBlock(block, options, false), headers);
+
+    // Split costs model byte coding only, so word blocks may prefer the
+    // coarser cuts; the exhaustive search is kept only when it really wins
+    if (options.optimalSplit) {
+        std::vector<BlockHeader> optimalHeaders;
+        std::string optimal = frameSplit(splitBlock(block, options, true), optimalHeaders);
+        if (optimal.length() < framed.length()) {
+            framed.swap(optimal);
+            headers.swap(optimalHeaders);
+        }
+    }
+
+    if (headers.size() > 1) {
+        Stats::global().increment("split_blocks", headers.size() - 1);
+    }
+    return framed;
+}
+
+std::string Compressor::frameIndex(const std::vector<BlockIndexEntry>& index) {
+    std::ostringstream out(std::ios::binary);
+    writeValue<uint8_t>(out, BLOCK_INDEX);
+    for (const auto& entry : index) {
+        writeValue<uint64_t>(out, entry.rawOffset);
+        writeValue<uint64_t>(out, entry.fileOffset);
+        writeValue<uint32_t>(out, entry.rawSize);
+    }
+    writeValue<uint32_t>(out, static_cast<uint32_t>(index.size()));
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    return out.str();
+}
+
+std::string Compressor::frameFilters(const std::vector<BlockFilter>& filters) {
+    std::ostringstream payload(std::ios::binary);
+    writeValue<uint32_t>(payload, static_cast<uint32_t>(filters.size()));
+    for (const BlockFilter& filter : filters) {
+        filter.write(payload);
+    }
+
+    BlockHeader header;
+    header.mode = BLOCK_FILTER;
+    header.rawSize = 0;
+    header.payloadSize = static_cast<uint32_t>(payload.tellp());
+    header.checksum = crc32c(std::string());
+
+    std::ostringstream out(std::ios::binary);
+    writeBlock(out, header, payload.str());
+    return out.str();
+}
+
+size_t Compressor::framedBlockSize(const char* data, size_t available, BlockHeader& header) {
+    if (available < BLOCK_HEADER_SIZE) return 0;
+
+    // Same field layout as writeBlock: raw host-order values
+    header.mode = static_cast<BlockMode>(static_cast<uint8_t>(data[0]));
+    std::memcpy(&header.rawSize, data + 1, sizeof(uint32_t));
+    std::memcpy(&header.payloadSize, data + 1 + sizeof(uint32_t), sizeof(uint32_t));
+    std::memcpy(&header.checksum, data + 1 + 2 * sizeof(uint32_t), sizeof(uint32_t));
+
+    size_t size = BLOCK_HEADER_SIZE + header.payloadSize;
+    return available >= size ? size : 0;
+}
+
+std::vector<size_t> Compressor::blockEnds(const std::string& text, const CompressOptions& options) {
+    if (options.contentDefined) {
+        return ChunkIndex::chunk(text.data(), text.length(), CONTENT_BLOCK_MIN, CONTENT_BLOCK_AVERAGE, CONTENT_BLOCK_MAX);
+    }
+
+    std::vector<size_t> ends;
+    for (size_t offset = 0; offset < text.length(); offset += options.blockSize) {
+        ends.push_back(std::min(offset + options.blockSize, text.length()));
+    }
+    return ends;
+}
+
+std::string Compressor::compress(const std::string& text, const CompressOptions& options) {
+    if (options.blockSize == 0) {
+        throw std::invalid_argument("Block size must be positive");
+    }
+
+    std::ostringstream out(std::ios::binary);
+    out.write(MAGIC, sizeof(MAGIC));
+
+    std::vector<BlockIndexEntry> index;
+    uint64_t fileOffset = sizeof(MAGIC);
+
+    if (options.dedup) {
+        writeDeduplicated(text, options, out, index);
+    } else {
+        size_t offset = 0;
+        for (size_t end : blockEnds(text, options)) {
+            std::vector<BlockHeader> headers;
+            out << frameBlocks(text.substr(offset, end - offset), options, headers);
+            uint64_t rawOffset = offset;
+            for (const BlockHeader& header : headers) {
+                index.push_back({rawOffset, fileOffset, header.rawSize});
+                rawOffset += header.rawSize;
+                fileOffset += BLOCK_HEADER_SIZE + header.payloadSize;
+            }
+            offset = end;
+        }
+    }
+
+    if (options.searchable && !index.empty()) {
+        std::vector<BlockFilter> filters;
+        for (const auto& entry : index) {
+            filters.push_back(BlockFilter::build(text.data() + entry.rawOffset, entry.rawSize));
+        }
+        out << frameFilters(filters);
+    }
+
+    if (options.seekable) {
+        out << frameIndex(index);
+    }
+
+    return out.str();
+}
+
+std::string Compressor::decompress(const std::string& data, const HuffmanTree* sharedTree,
+                                   const HistorySource& earlier, uint64_t rawBase) {
+    if (!isCompressed(data)) {
+        throw std::runtime_error("Not a compressed file (bad magic)");
+    }
+
+    std::istringstream in(data, std::ios::binary);
+    in.seekg(sizeof(MAGIC));
+
+    std::string output;
+    DecodeContext context;
+    context.sharedTree = sharedTree;
+    context.container = &in;
+    context.history = [&](uint64_t offset, uint64_t length) {
+        std::string bytes;
+        if (offset < rawBase) {
+            if (!earlier) {
+                throw std::runtime_error("Copy block refers to data outside this stream");
+            }
+            uint64_t count = std::min(length, rawBase - offset);
+            bytes = earlier(offset, count);
+            offset += count;
+            length -= count;
+        }
+        if (length > 0) {
+            if (offset - rawBase + length > output.length()) {
+                throw std::runtime_error("Copy block refers to data not yet decoded");
+            }
+            bytes.append(output, offset - rawBase, length);
+        }
+        return bytes;
+    };
+
+    BlockHeader header;
+    std::string payload;
+    for (size_t blockIndex = 0; readBlock(in, header, payload); ++blockIndex) {
+        output += decodeVerified(header, payload, blockIndex, context);
+    }
+
+    return output;
+}
+
+BlockMode Compressor::loadBlockTable(std::istream& container, uint64_t offset, HuffmanTree& tree, AnsTable& ansTable) {
+    std::streampos saved = container.tellg();
+    container.clear();
+    container.seekg(offset);
+    BlockMode mode = static_cast<BlockMode>(readValue<uint8_t>(container));
+    if (mode != BLOCK_HUFFMAN && mode != BLOCK_ANS) {
+        throw std::runtime_error("Table reference does not point at a Huffman or ANS block");
+    }
+
+    // The table leads the payload, so only it is read
+    container.seekg(offset + BLOCK_HEADER_SIZE);
+    if (mode == BLOCK_ANS) {
+        ansTable = AnsCoder::readTable(container);
+    } else if (!tree.loadTree(container)) {
+        throw std::runtime_error("Invalid block tree");
+    }
+    container.clear();
+    container.seekg(saved);
+    return mode;
+}
+
+bool Compressor::readIndex(std::istream& in, std::vector<BlockIndexEntry>& index) {
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    if (fileSize < sizeof(MAGIC) + 1 + INDEX_TRAILER_SIZE) return false;
+
+    in.seekg(fileSize - INDEX_TRAILER_SIZE);
+    uint32_t count = readValue<uint32_t>(in);
+    char magic[4];
+    if (!in.read(magic, sizeof(magic)) || std::string(magic, 4) != std::string(INDEX_MAGIC, 4)) {
+        return false;
+    }
+
+    uint64_t indexSize = 1 + static_cast<uint64_t>(count) * INDEX_ENTRY_SIZE + INDEX_TRAILER_SIZE;
+    if (indexSize > fileSize - sizeof(MAGIC)) {
+        throw std::runtime_error("Corrupt block index");
+    }
+
+    uint64_t indexStart = fileSize - indexSize;
+    in.seekg(indexStart);
+    if (readValue<uint8_t>(in) != BLOCK_INDEX) {
+        throw std::runtime_error("Corrupt block index");
+    }
+
+    index.clear();
+    index.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        BlockIndexEntry entry;
+        entry.rawOffset = readValue<uint64_t>(in);
+        entry.fileOffset = readValue<uint64_t>(in);
+        entry.rawSize = readValue<uint32_t>(in);
+        // Blocks follow the magic in order and cover the raw data without gaps
+        uint64_t expectedRaw = index.empty() ? 0 : index.back().rawOffset + index.back().rawSize;
+        uint64_t minimumFile = index.empty() ? sizeof(MAGIC) : index.back().fileOffset + BLOCK_HEADER_SIZE;
+        if (entry.rawOffset != expectedRaw || entry.fileOffset < minimumFile ||
+            entry.fileOffset > indexStart || indexStart - entry.fileOffset < BLOCK_HEADER_SIZE ||
+            (index.empty() && entry.fileOffset != sizeof(MAGIC))) {
+            throw std::runtime_error("Corrupt block index");
+        }
+        index.push_back(entry);
+    }
+
+    // Past the last block only filter and skip blocks may come before the index
+    uint64_t pos = index.empty() ? sizeof(MAGIC) : index.back().fileOffset;
+    while (pos < indexStart) {
+        if (indexStart - pos < BLOCK_HEADER_SIZE) {
+            throw std::runtime_error("Corrupt block index");
+        }
+        in.clear();
+        in.seekg(pos);
+        BlockHeader header;
+        header.mode = static_cast<BlockMode>(readValue<uint8_t>(in));
+        header.rawSize = readValue<uint32_t>(in);
+        header.payloadSize = readValue<uint32_t>(in);
+        bool indexed = !index.empty() && pos == index.back().fileOffset;
+        if (indexed ? header.rawSize != index.back().rawSize
+                    : (header.mode != BLOCK_FILTER && header.mode != BLOCK_SKIP) || header.rawSize != 0) {
+            throw std::runtime_error("Corrupt block index");
+        }
+        pos += BLOCK_HEADER_SIZE + header.payloadSize;
+    }
+    if (pos != indexStart) {
+        throw std::runtime_error("Corrupt block index");
+    }
+    return true;
+}
+
+std::string Compressor::decompressRange(std::istream& in, uint64_t offset, uint64_t length) {
+    std::vector<BlockIndexEntry> index;
+    if (!readIndex(in, index)) {
+        in.clear();
+        in.seekg(0);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::string all = decompress(data);
+        return offset < all.length() ? all.substr(offset, length) : std::string();
+    }
+
+    // First block whose range ends after offset
+    size_t first = 0, last = index.size();
+    while (first < last) {
+        size_t mid = (first + last) / 2;
+        if (index[mid].rawOffset + index[mid].rawSize <= offset) first = mid + 1;
+        else last = mid;
+    }
+
+    std::string output;
+    uint64_t end = length > UINT64_MAX - offset ? UINT64_MAX : offset + length;
+    BlockHeader header;
+    std::string payload;
+
+    // Copied bytes are fetched through the index like any other range
+    DecodeContext context;
+    context.container = &in;
+    context.history = [&in](uint64_t from, uint64_t count) {
+        return decompressRange(in, from, count);
+    };
+
+    for (size_t i = first; i < index.size() && index[i].rawOffset < end; ++i) {
+        in.clear();
+        in.seekg(index[i].fileOffset);
+        if (!readBlock(in, header, payload)) {
+            throw std::runtime_error("Block index points past the block list");
+        }
+        std::string block = decodeVerified(header, payload, i, context);
+
+        uint64_t from = offset > index[i].rawOffset ? offset - index[i].rawOffset : 0;
+        uint64_t to = end - index[i].rawOffset < block.length() ? end - index[i].rawOffset : block.length();
+        output.append(block, from, to - from);
+    }
+
+    return output;
+}
+
+std::string Compressor::decompressRange(const std::string& data, uint64_t offset, uint64_t length) {
+    std::istringstream in(data, std::ios::binary);
+    return decompressRange(in, offset, length);
+}
+
+std::unordered_map<char, int> Compressor::histogram(const std::string& text) {
+    ScopedPhase phase("histogram");
+    int counts[256] = {0};
+    for (char ch : text) {
+        counts[static_cast<unsigned char>(ch)]++;
+    }
+
+    std::unordered_map<char, int> freqMap;
+    for (int i = 0; i < 256; ++i) {
+        if (counts[i] > 0) freqMap[static_cast<char>(i)] = counts[i];
+    }
+    return freqMap;
+}
+
+// Counts every 2^sampleShift-th stripe and scales up. Every byte value keeps
+// a count, since the stripes not looked at may contain any of them.
+std::unordered_map<char, int> Compressor::sampledHistogram(const std::string& text, int sampleShift) {
+    ScopedPhase phase("histogram");
+    uint64_t counts[256] = {0};
+    size_t step = SAMPLE_STRIPE << sampleShift;
+    for (size_t start = 0; start < text.length(); start += step) {
+        size_t end = std::min(start + SAMPLE_STRIPE, text.length());
+        for (size_t i = start; i < end; ++i) {
+            counts[static_cast<unsigned char>(text[i])]++;
+        }
+    }
+
+    std::unordered_map<char, int> freqMap;
+    for (int i = 0; i < 256; ++i) {
+        freqMap[static_cast<char>(i)] = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(counts[i] << sampleShift, INT32_MAX)));
+    }
+    return freqMap;
+}
+
+// Smallest payload among the table-coded and stored choices of encodeBlock
+size_t Compressor::estimateBlockPayload(const std::unordered_map<char, int>& freqMap, size_t length,
+                                        const CompressOptions& options) {
+    size_t best = std::min(length, estimateHuffmanPayload(freqMap));
+    if (options.sharedTree) {
+        best = std::min(best, estimateSharedPayload(*options.sharedTree, freqMap));
+    }
+    uint64_t builtinBits;
+    BuiltinTable::best(freqMap, builtinBits);
+    best = std::min(best, estimateBuiltinPayload(builtinBits));
+    // Word blocks are left out of the ANS estimate: it makes small pieces look
+    // cheap, but each word-coded piece then stores its own vocabulary, and
+    // splitting on it grew 9.5 MB of prose at -9 from 3.70 MB to 4.14 MB
+    return options.words ? best : std::min(best, AnsCoder::estimatePayload(freqMap));
+}
+
+// Block lengths for one input block. Costs come from per-segment histograms,
+// so no candidate is encoded. Bisection cuts a range at its cheapest point
+// while that beats keeping it whole; the optimal search tries every set of cuts.
+std::vector<size_t> Compressor::splitBlock(const std::string& block, const CompressOptions& options, bool optimal) {
+    // Content-defined blocks stay whole, so update can match them one to one
+    size_t split = options.splitSize;
+    if (split == 0 || options.lzLevel > 0 || options.contentDefined || block.length() < 2 * split) {
+        return std::vector<size_t>(1, block.length());
+    }
+
+    ScopedPhase phase("split");
+    size_t segments = (block.length() + split - 1) / split;
+    std::vector<std::array<uint32_t, 256>> prefix(segments + 1);
+    prefix[0].fill(0);
+    for (size_t k = 0; k < segments; ++k) {
+        prefix[k + 1] = prefix[k];
+        size_t end = std::min((k + 1) * split, block.length());
+        for (size_t i = k * split; i < end; ++i) {
+            prefix[k + 1][static_cast<unsigned char>(block[i])]++;
+        }
+    }
+
+    auto boundary = [&](size_t k) { return std::min(k * split, block.length()); };
+    auto cost = [&](size_t from, size_t to) {
+        std::unordered_map<char, int> freqMap;
+        for (int ch = 0; ch < 256; ++ch) {
+            uint32_t count = prefix[to][ch] - prefix[from][ch];
+            if (count > 0) freqMap[static_cast<char>(ch)] = static_cast<int>(count);
+        }
+        return BLOCK_HEADER_SIZE + estimateBlockPayload(freqMap, boundary(to) - boundary(from), options);
+    };
+
+    std::vector<size_t> cuts;
+    if (optimal) {
+        std::vector<size_t> best(segments + 1, SIZE_MAX), previous(segments + 1, 0);
+        best[0] = 0;
+        for (size_t to = 1; to <= segments; ++to) {
+            for (size_t from = 0; from < to; ++from) {
+                size_t candidate = best[from] + cost(from, to);
+                if (candidate < best[to]) {
+                    best[to] = candidate;
+                    previous[to] = from;
+                }
+            }
+        }
+        for (size_t at = previous[segments]; at > 0; at = previous[at]) cuts.push_back(at);
+        std::reverse(cuts.begin(), cuts.end());
+    } else {
+        std::function<void(size_t, size_t)> bisect = [&](size_t from, size_t to) {
+            size_t best = cost(from, to), at = 0;
+            for (size_t k = from + 1; k < to; ++k) {
+                size_t candidate = cost(from, k) + cost(k, to);
+                if (candidate < best) {
+                    best = candidate;
+                    at = k;
+                }
+            }
+            if (at == 0) return;
+            bisect(from, at);
+            cuts.push_back(at);
+            bisect(at, to);
+        };
+        bisect(0, segments);
+    }
+
+    std::vector<size_t> lengths;
+    size_t start = 0;
+    for (size_t at : cuts) {
+        lengths.push_back(boundary(at) - start);
+        start = boundary(at);
+    }
+    lengths.push_back(block.length() - start);
+    return lengths;
+}
+
+size_t Compressor::estimateHuffmanPayload(const std::unordered_map<char, int>& freqMap) {
+    uint64_t bits = HuffmanTree::estimateEncodedBits(freqMap);
+    return HuffmanTree::serializedTreeSize(freqMap.size()) + sizeof(uint64_t) + (bits + 7) / 8;
+}
+
+size_t Compressor::estimateSharedPayload(const HuffmanTree& sharedTree, const std::unordered_map<char, int>& freqMap) {
+    const auto& codes = sharedTree.getCodes();
+    uint64_t bits = 0;
+    for (const auto& pair : freqMap) {
+        auto it = codes.find(pair.first);
+        if (it == codes.end()) return SIZE_MAX;
+        bits += static_cast<uint64_t>(pair.second) * it->second.length();
+    }
+    return sizeof(uint64_t) + (bits + 7) / 8;
+}
+
+void Compressor::writeDeduplicated(const std::string& text, const CompressOptions& options, std::ostream& out,
+                                   std::vector<BlockIndexEntry>& index) {
+    std::vector<size_t> boundaries;
+    {
+        ScopedPhase phase("chunking");
+        boundaries = ChunkIndex::chunk(text.data(), text.length());
+    }
+
+    ChunkIndex localChunks;
+    ChunkIndex& chunks = options.chunkIndex ? *options.chunkIndex : localChunks;
+
+    // Unique runs between copies are often small; after the first coded block
+    // they may borrow its tree instead of storing one each
+    CompressOptions blockOptions = options;
+    HuffmanTree reference;
+    AnsTable referenceAns;
+
+    auto write = [&](const std::string& framed, const BlockHeader& header, uint64_t rawOffset) {
+        uint64_t fileOffset = static_cast<uint64_t>(out.tellp());
+        out << framed;
+        index.push_back({rawOffset, fileOffset, header.rawSize});
+
+        if ((header.mode == BLOCK_HUFFMAN || header.mode == BLOCK_ANS) &&
+            !blockOptions.referenceTree && !blockOptions.referenceAns) {
+            std::istringstream in(framed, std::ios::binary);
+            if (loadBlockTable(in, 0, reference, referenceAns) == BLOCK_ANS) {
+                blockOptions.referenceAns = &referenceAns;
+            } else {
+                blockOptions.referenceTree = &reference;
+            }
+            blockOptions.referenceTreeOffset = fileOffset;
+        }
+    };
+
+    // Pending unique bytes [uniqueStart, uniqueEnd) and pending copy run
+    size_t uniqueStart = 0, uniqueEnd = 0;
+    size_t copyStart = 0, copyLength = 0;
+    uint64_t copySource = 0;
+
+    auto flushUnique = [&](bool all) {
+        while (uniqueEnd - uniqueStart >= options.blockSize || (all && uniqueEnd > uniqueStart)) {
+            size_t length = std::min(options.blockSize, uniqueEnd - uniqueStart);
+            BlockHeader header;
+            write(frameBlock(text.substr(uniqueStart, length), blockOptions, header), header, uniqueStart);
+            uniqueStart += length;
+        }
+    };
+
+    auto flushCopy = [&]() {
+        if (copyLength == 0) return;
+        BlockHeader header;
+        header.mode = BLOCK_COPY;
+        header.rawSize = static_cast<uint32_t>(copyLength);
+        header.payloadSize = sizeof(uint64_t);
+        header.checksum = crc32c(text.data() + copyStart, copyLength);
+
+        std::ostringstream payload(std::ios::binary);
+        writeValue<uint64_t>(payload, copySource);
+        std::ostringstream framed(std::ios::binary);
+        writeBlock(framed, header, payload.str());
+        write(framed.str(), header, copyStart);
+        Stats::global().increment("coded_blocks");
+        copyLength = 0;
+    };
+
+    size_t start = 0;
+    for (size_t end : boundaries) {
+        size_t length = end - start;
+        uint64_t source;
+        if (chunks.find(text.data() + start, length, source)) {
+            flushUnique(true);
+            if (copyLength > 0 && (copySource + copyLength != source || copyLength + length > options.blockSize)) {
+                flushCopy();
+            }
+            if (copyLength == 0) {
+                copySource = source;
+                copyStart = start;
+            }
+            copyLength += length;
+            Stats::global().increment("dedup_bytes", length);
+        } else {
+            flushCopy();
+            chunks.add(text.data() + start, length, options.rawBase + start);
+            if (uniqueStart == uniqueEnd) uniqueStart = start;
+            uniqueEnd = end;
+            flushUnique(false);
+        }
+        start = end;
+    }
+    flushUnique(true);
+    flushCopy();
+}
+
+size_t Compressor::estimateBuiltinPayload(uint64_t bits) {
+    return sizeof(uint8_t) + sizeof(uint64_t) + (bits + 7) / 8;
+}
+
+std::string Compressor::encodeBlock(const std::string& block, const CompressOptions& options, BlockMode& mode) {
+    if (options.words) {
+        // Pays off on prose; byte-oriented data keeps whichever byte coding wins
+        CompressOptions byteOptions = options;
+        byteOptions.words = false;
+        std::string payload = encodeBlock(block, byteOptions, mode);
+        std::string wordPayload = WordCoder::compress(block, options.optimalCodes);
+        if (wordPayload.length() < payload.length()) {
+            Stats::global().increment("word_blocks");
+            mode = BLOCK_WORD;
+            return wordPayload;
+        }
+        return payload;
+    }
+
+    if (options.lzLevel > 0) {
+        std::string payload = LZ77(options.lzLevel).compress(block);
+        if (payload.length() < block.length()) {
+            mode = BLOCK_LZ77;
+            return payload;
+        }
+        mode = BLOCK_STORED;
+        return block;
+    }
+
+    // Skip the encoder entirely when the exact output size shows it cannot pay.
+    // Low levels estimate from a sample of the block instead.
+    bool sampled = options.sampleShift > 0 && block.length() >= 8 * (SAMPLE_STRIPE << options.sampleShift);
+    std::unordered_map<char, int> freqMap = sampled ? sampledHistogram(block, options.sampleShift) : histogram(block);
+    size_t ownSize = estimateHuffmanPayload(freqMap);
+    size_t sharedSize = options.sharedTree ? estimateSharedPayload(*options.sharedTree, freqMap) : SIZE_MAX;
+    uint64_t builtinBits;
+    const BuiltinTable& builtin = BuiltinTable::best(freqMap, builtinBits);
+    size_t builtinSize = estimateBuiltinPayload(builtinBits);
+    size_t huffmanSize = std::min(std::min(ownSize, sharedSize), builtinSize);
+    size_t ansSize = AnsCoder::estimatePayload(freqMap);
+    if (std::min(huffmanSize, ansSize) >= block.length()) {
+        mode = BLOCK_STORED;
+        return block;
+    }
+
+    // Reusing the file's existing table is worth a little size
+    size_t bestSize = std::min(huffmanSize, ansSize);
+    if (options.referenceTree || options.referenceAns) {
+        size_t referenceSize = options.referenceTree ? estimateSharedPayload(*options.referenceTree, freqMap)
+                                                     : AnsCoder::estimateStream(*options.referenceAns, freqMap);
+        if (referenceSize != SIZE_MAX) referenceSize += sizeof(uint64_t);
+        if (referenceSize < block.length() && referenceSize <= bestSize + bestSize * REUSE_TOLERANCE_PERCENT / 100) {
+            std::ostringstream out(std::ios::binary);
+            writeValue<uint64_t>(out, options.referenceTreeOffset);
+            if (options.referenceTree) {
+                writeCoded(out, block, *options.referenceTree);
+            } else {
+                AnsCoder::writeStream(out, block, *options.referenceAns);
+            }
+
+            Stats::global().increment("reused_table_blocks");
+            mode = BLOCK_REUSE;
+            return out.str();
+        }
+    }
+
+    // Fractional code lengths win on skewed blocks, and a frequency table is
+    // smaller than a tree; the estimate is close, so check the real size
+    if (ansSize < huffmanSize) {
+        std::string payload = AnsCoder::compress(block, freqMap);
+        if (payload.length() < huffmanSize) {
+            Stats::global().increment("ans_blocks");
+            mode = BLOCK_ANS;
+            return payload;
+        }
+    }
+
+    // Small blocks of ordinary text usually end here, skipping the tree build
+    if (builtinSize < std::min(ownSize, sharedSize)) {
+        SymbolCodes table;
+        symbolCodes(builtin, table);
+        std::ostringstream out(std::ios::binary);
+        writeValue<uint8_t>(out, builtin.id());
+        writePacked(out, block, table);
+
+        mode = BLOCK_BUILTIN;
+        return out.str();
+    }
+
+    if (sharedSize <= ownSize) {
+        std::ostringstream out(std::ios::binary);
+        writeCoded(out, block, *options.sharedTree);
+
+        mode = BLOCK_SHARED;
+        return out.str();
+    }
+
+    HuffmanTree huffman;
+    huffman.buildTree(freqMap);
+    if (Stats::global().isEnabled()) {
+        Stats::global().recordTree(freqMap.size(), huffman.getTreeHeight(), huffman.getAverageCodeLength(), block.length());
+    }
+
+    std::ostringstream out(std::ios::binary);
+    if (!huffman.saveTree(out)) {
+        throw std::runtime_error("Failed to write block tree");
+    }
+    writeCoded(out, block, huffman);
+
+    mode = BLOCK_HUFFMAN;
+    return out.str();
+}
+
+std::string Compressor::decodeBlock(const BlockHeader& header, const std::string& payload, const DecodeContext& context) {
+    std::string decoded;
+
+    switch (header.mode) {
+        case BLOCK_STORED:
+            decoded = payload;
+            break;
+        case BLOCK_HUFFMAN: {
+            std::istringstream in(payload, std::ios::binary);
+            HuffmanTree huffman;
+            if (!huffman.loadTree(in)) {
+                throw std::runtime_error("Invalid block tree");
+            }
+            uint64_t bitCount = readValue<uint64_t>(in);
+            std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            decoded = huffman.decode(unpackBits(packed, bitCount));
+            break;
+        }
+        case BLOCK_LZ77:
+            decoded = LZ77::decompress(payload);
+            break;
+        case BLOCK_SHARED: {
+            if (!context.sharedTree) {
+                throw std::runtime_error("Block needs a shared code table");
+            }
+            std::istringstream in(payload, std::ios::binary);
+            uint64_t bitCount = readValue<uint64_t>(in);
+            std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            decoded = context.sharedTree->decode(unpackBits(packed, bitCount));
+            break;
+        }
+        case BLOCK_BUILTIN: {
+            std::istringstream in(payload, std::ios::binary);
+            const BuiltinTable& table = BuiltinTable::get(static_cast<BuiltinTableId>(readValue<uint8_t>(in)));
+            uint64_t bitCount = readValue<uint64_t>(in);
+            std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            decoded = table.decode(unpackBits(packed, bitCount));
+            break;
+        }
+        case BLOCK_REUSE: {
+            if (!context.container) {
+                throw std::runtime_error("Block needs the table of another block");
+            }
+            std::istringstream in(payload, std::ios::binary);
+            HuffmanTree huffman;
+            AnsTable ansTable;
+            if (loadBlockTable(*context.container, readValue<uint64_t>(in), huffman, ansTable) == BLOCK_ANS) {
+                decoded = AnsCoder::readStream(in, ansTable, header.rawSize);
+                break;
+            }
+            uint64_t bitCount = readValue<uint64_t>(in);
+            std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            decoded = huffman.decode(unpackBits(packed, bitCount));
+            break;
+        }
+        case BLOCK_WORD:
+            decoded = WordCoder::decompress(payload);
+            break;
+        case BLOCK_ANS:
+            decoded = AnsCoder::decompress(payload, header.rawSize);
+            break;
+        case BLOCK_SKIP:
+        case BLOCK_FILTER:
+            break;
+        case BLOCK_COPY: {
+            if (!context.history) {
+                throw std::runtime_error("Block needs earlier decoded data");
+            }
+            std::istringstream in(payload, std::ios::binary);
+            decoded = context.history(readValue<uint64_t>(in), header.rawSize);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown block mode " + std::to_string(header.mode));
+    }
+
+    if (decoded.length() != header.rawSize) {
+        throw std::runtime_error("Block size mismatch after decoding");
+    }
+    return decoded;
+}
@@ -0,0 +1,198 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <functional>
+
+// A compressed file is a magic tag followed by independently decodable
+// blocks. Each block carries its own code tables, so no .tree sidecar is needed.
+enum BlockMode : uint8_t {
+    BLOCK_STORED = 0,    // Raw bytes, used when coding would not shrink the block
+    BLOCK_HUFFMAN = 1,   // Single HuffmanTree over the block bytes
+    BLOCK_LZ77 = 2,      // LZ77 sequences with literal/length/distance trees
+    BLOCK_SHARED = 3,    // Huffman coded with a table stored outside the block (see Archive)
+    BLOCK_BUILTIN = 4,   // Coded with a compile-time table (see BuiltinTables), named by one id byte
+    BLOCK_REUSE = 5,     // Coded with the table of an earlier BLOCK_HUFFMAN or BLOCK_ANS block, named by its file offset
+    BLOCK_SKIP = 6,      // Decodes to nothing; covers an index superseded by Appender
+    BLOCK_COPY = 7,      // Repeats earlier uncompressed bytes, named by their raw offset (see ChunkIndex)
+    BLOCK_WORD = 8,      // Huffman coded words and separators with their vocabulary (see WordCoder)
+    BLOCK_FILTER = 9,    // Decodes to nothing; byte and pair filters of the preceding blocks (see Search)
+    BLOCK_ANS = 10,      // tANS coded with normalized byte frequencies (see AnsCoder)
+    BLOCK_INDEX = 0xFF   // End of blocks; a seekable file's index follows
+};
+
+struct BlockHeader {
+    BlockMode mode;
+    uint32_t rawSize;
+    uint32_t payloadSize;
+    uint32_t checksum;   // CRC32C of the uncompressed block
+};
+
+// Seekable files end with: BLOCK_INDEX marker, one entry per block,
+// uint32 entry count, INDEX_MAGIC
+struct BlockIndexEntry {
+    uint64_t rawOffset;     // Offset of the block's first byte in the uncompressed data
+    uint64_t fileOffset;    // Offset of the block header in the compressed file
+    uint32_t rawSize;
+};
+
+class HuffmanTree;
+class ChunkIndex;
+struct AnsTable;
+struct BlockFilter;
+
+// Supplies already decoded bytes [offset, offset + length) to BLOCK_COPY blocks
+typedef std::function<std::string(uint64_t offset, uint64_t length)> HistorySource;
+
+// What a block may need besides its own payload
+struct DecodeContext {
+    const HuffmanTree* sharedTree = nullptr;   // BLOCK_SHARED
+    std::istream* container = nullptr;         // BLOCK_REUSE; its read position is restored
+    HistorySource history;                     // BLOCK_COPY
+};
+
+struct CompressOptions {
+    size_t blockSize = 1 << 20;
+    int lzLevel = 0;        // 0 disables the LZ77 stage, otherwise 1-9
+    bool seekable = false;  // Write a trailing block index for random access
+    bool words = false;     // Also try word-level coding per block and keep it when smaller
+    bool searchable = false; // Write per-block filters so search can skip blocks without decoding them
+    bool contentDefined = false; // Cut blocks where the content says (see ChunkIndex), so update can reuse them
+
+    // Speed/ratio trade-offs, normally set together by Compressor::applyLevel
+    int sampleShift = 0;        // Histogram from 1 in 2^sampleShift 4 KB stripes; 0 counts every byte
+    size_t splitSize = 0;       // Split blocks where their statistics change, at this granularity; 0 never splits
+    bool optimalSplit = false;  // Also search all split points, keeping whichever cuts code smaller
+    bool optimalCodes = false;  // Package-merge instead of heuristic code length limiting (word blocks)
+
+    // Optional table shared by several streams; blocks use it when that is
+    // cheaper than carrying their own tree. The decoder must be given the same table.
+    const HuffmanTree* sharedTree = nullptr;
+
+    // Table of the BLOCK_HUFFMAN or BLOCK_ANS block at referenceTreeOffset in the
+    // file being extended (see Appender); at most one of the two is set. Blocks
+    // point to it when within REUSE_TOLERANCE_PERCENT of the best alternative,
+    // saving the table build on encode and the table parse on decode.
+    const HuffmanTree* referenceTree = nullptr;
+    const AnsTable* referenceAns = nullptr;
+    uint64_t referenceTreeOffset = 0;
+
+    // Split the input at content-defined chunk boundaries and store repeated
+    // chunks as BLOCK_COPY references; only unique chunks are entropy coded.
+    // A caller-owned chunkIndex carries chunks across streams (see Archive),
+    // with rawBase placing this stream after the ones already indexed.
+    bool dedup = false;
+    ChunkIndex* chunkIndex = nullptr;
+    uint64_t rawBase = 0;
+};
+
+class Compressor {
+public:
+    static const char MAGIC[4];
+    static const char INDEX_MAGIC[4];
+    static const size_t SEEKABLE_BLOCK_SIZE = 64 * 1024;
+    static const size_t BLOCK_HEADER_SIZE = 1 + 3 * sizeof(uint32_t);
+    static const int REUSE_TOLERANCE_PERCENT = 10;
+
+    // Block sizes with options.contentDefined; an edit re-encodes about one average block
+    static const size_t CONTENT_BLOCK_MIN = 16 * 1024;
+    static const size_t CONTENT_BLOCK_AVERAGE = 64 * 1024;
+    static const size_t CONTENT_BLOCK_MAX = 256 * 1024;
+
+    // Level 1 is fastest, 9 compresses best; 3 matches the default options
+    static const int MIN_LEVEL = 1;
+    static const int MAX_LEVEL = 9;
+    static const int DEFAULT_LEVEL = 3;
+
+    // Sets block size, statistics, splitting and word coding for a level.
+    // Every level writes ordinary block modes, so decoding is unaffected.
+    static void applyLevel(CompressOptions& options, int level);
+
+    static std::string compress(const std::string& text, const CompressOptions& options = CompressOptions());
+    // earlier resolves copies of bytes before rawBase, i.e. from other streams
+    static std::string decompress(const std::string& data, const HuffmanTree* sharedTree = nullptr,
+                                  const HistorySource& earlier = HistorySource(), uint64_t rawBase = 0);
+
+    // True if data starts with the container magic (as opposed to a legacy bit string)
+    static bool isCompressed(const std::string& data);
+
+    // Random access: decode only the blocks covering [offset, offset + length).
+    // Uses the trailing index when present, otherwise falls back to a full decode.
+    static std::string decompressRange(std::istream& in, uint64_t offset, uint64_t length);
+    static std::string decompressRange(const std::string& data, uint64_t offset, uint64_t length);
+
+    // Reads the trailing block index; returns false if the file was not written seekable
+    static bool readIndex(std::istream& in, std::vector<BlockIndexEntry>& index);
+
+    // Exact size of a BLOCK_HUFFMAN payload for this text, computed from the
+    // histogram alone without building the tree or encoding
+    static size_t estimateHuffmanPayload(const std::unordered_map<char, int>& freqMap);
+
+    // Size of a BLOCK_SHARED payload, or SIZE_MAX if the table lacks a symbol
+    static size_t estimateSharedPayload(const HuffmanTree& sharedTree, const std::unordered_map<char, int>& freqMap);
+    static std::unordered_map<char, int> histogram(const std::string& text);
+
+    // Size of a BLOCK_BUILTIN payload using the best built-in table
+    static size_t estimateBuiltinPayload(uint64_t bits);
+
+    // Container pieces for callers that produce or consume blocks
+    // incrementally (see Pipeline). frameBlock returns header plus payload.
+    static std::string frameBlock(const std::string& block, const CompressOptions& options, BlockHeader& header);
+    static std::string frameIndex(const std::vector<BlockIndexEntry>& index);
+    static std::string frameFilters(const std::vector<BlockFilter>& filters);
+
+    // End offsets of the blocks compress cuts text into, before any splitting
+    static std::vector<size_t> blockEnds(const std::string& text, const CompressOptions& options);
+
+    // Like frameBlock, but with options.splitSize the block may come out as
+    // several blocks, one header each, cut where the statistics change
+    static std::string frameBlocks(const std::string& block, const CompressOptions& options, std::vector<BlockHeader>& headers);
+
+    // Size of the framed block at data, or 0 if fewer than that many bytes are available
+    static size_t framedBlockSize(const char* data, size_t available, BlockHeader& header);
+
+    static std::string decodeVerified(const BlockHeader& header, const std::string& payload, size_t blockIndex,
+                                      const DecodeContext& context = DecodeContext());
+
+    // Read the block at the current position; return false at the end of the
+    // block list (end of data or the index marker). readBlockHeader leaves the
+    // stream at the payload, so callers may seek past it.
+    static bool readBlockHeader(std::istream& in, BlockHeader& header);
+    static bool readBlock(std::istream& in, BlockHeader& header, std::string& payload);
+
+    // Loads the table of the BLOCK_HUFFMAN or BLOCK_ANS block whose header
+    // starts at offset into tree or ansTable, and returns which mode it has
+    static BlockMode loadBlockTable(std::istream& container, uint64_t offset, HuffmanTree& tree, AnsTable& ansTable);
+
+private:
+    struct LevelConfig {
+        size_t blockSize;
+        int sampleShift;
+        size_t splitSize;
+        bool optimalSplit;
+        bool words;
+        bool optimalCodes;
+    };
+
+    static const LevelConfig LEVELS[MAX_LEVEL + 1];
+    static const size_t SAMPLE_STRIPE = 4096;
+
+    static std::unordered_map<char, int> sampledHistogram(const std::string& text, int sampleShift);
+    static size_t estimateBlockPayload(const std::unordered_map<char, int>& freqMap, size_t length, const CompressOptions& options);
+    static std::vector<size_t> splitBlock(const std::string& block, const CompressOptions& options, bool optimal);
+
+    static std::string encodeBlock(const std::string& block, const CompressOptions& options, BlockMode& mode);
+    static std::string decodeBlock(const BlockHeader& header, const std::string& payload, const DecodeContext& context);
+    static void writeDeduplicated(const std::string& text, const CompressOptions& options, std::ostream& out,
+                                  std::vector<BlockIndexEntry>& index);
+
+    static void writeBlock(std::ostream& out, const BlockHeader& header, const std::string& payload);
+};
+
+#endif // COMPRESSOR_H
@@ -0,0 +1,16 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// CRC32C (Castagnoli). Uses the SSE4.2 / ARMv8 CRC instructions when the
+// CPU has them and a slicing-by-8 table otherwise; all paths agree bit for bit.
+uint32_t crc32c(const char* data, size_t length, uint32_t crc = 0);
+uint32_t crc32c(const std::string& data, uint32_t crc = 0);
+
+// True if the hardware path is in use (for diagnostics)
+bool crc32cHardwareAccelerated();
+
+#endif // CRC32C_H
@@ -1,10 +1,12 @@
 #include "HuffmanTree.h"
+#include "Stats.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
+#include <functional>
 
 HuffmanTree::HuffmanTree() : root(nullptr) {
 }
@@ -19,8 +21,11 @@ void HuffmanTree::buildTree(const std::string& text) {
     }
 
     frequencies.clear();
-    for (char ch : text) {
-        frequencies[ch]++;
+    {
+        ScopedPhase phase("histogram");
+        for (char ch : text) {
+            frequencies[ch]++;
+        }
     }
 
     buildTree(frequencies);
@@ -33,36 +38,41 @@ void HuffmanTree::buildTree(const std::unordered_map<char, int>& freqMap) {
 
     frequencies = freqMap;
 
-    // Create priority queue with NodeComparator for deterministic tie-breaking
-    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, NodeComparator> pq;
+    {
+        ScopedPhase phase("tree_build");
 
-    // Sort characters to ensure deterministic processing order
-    std::vector<std::pair<char, int>> sortedFreqs(frequencies.begin(), frequencies.end());
-    std::sort(sortedFreqs.begin(), sortedFreqs.end());
+        // Create priority queue with NodeComparator for deterministic tie-breaking
+        std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, NodeComparator> pq;
 
-    // Add all characters as leaf nodes to the priority queue in sorted order
-    for (const auto& pair : sortedFreqs) {
-        pq.push(std::make_shared<Node>(pair.first, pair.second));
-    }
+        // Sort characters to ensure deterministic processing order
+        std::vector<std::pair<char, int>> sortedFreqs(frequencies.begin(), frequencies.end());
+        std::sort(sortedFreqs.begin(), sortedFreqs.end());
 
-    // Special case: only one unique character
-    if (pq.size() == 1) {
-        auto single = pq.top(); 
-        pq.pop();
-        root = std::make_shared<Node>(single->frequency, single, nullptr);
-    } else {
-        // Build the tree by merging nodes
-        while (pq.size() > 1) {
-            auto right = pq.top(); pq.pop();
-            auto left = pq.top(); pq.pop();
+        // Add all characters as leaf nodes to the priority queue in sorted order
+        for (const auto& pair : sortedFreqs) {
+            pq.push(std::make_shared<Node>(pair.first, pair.second));
+        }
 
-            auto merged = std::make_shared<Node>(left->frequency + right->frequency, left, right);
-            pq.push(merged);
+        // Special case: only one unique character
+        if (pq.size() == 1) {
+            auto single = pq.top(); 
+            pq.pop();
+            root = std::make_shared<Node>(single->frequency, single, nullptr);
+        } else {
+            // Build the tree by merging nodes
+            while (pq.size() > 1) {
+                auto right = pq.top(); pq.pop();
+                auto left = pq.top(); pq.pop();
+
+                auto merged = std::make_shared<Node>(left->frequency + right->frequency, left, right);
+                pq.push(merged);
+            }
+            root = pq.top();
         }
-        root = pq.top();
     }
 
     // Generate codes
+    ScopedPhase phase("code_gen");
     codes.clear();
     if (root->isLeaf()) {
         // Special case: single character gets code "0"
@@ -101,6 +111,7 @@ std::string HuffmanTree::encode(const std::string& text) const {
         throw std::runtime_error("Tree not built - no codes available");
     }
 
+    ScopedPhase phase("encode");
     std::string encoded;
     encoded.reserve(text.length() * 8); // Reserve space for efficiency
 
@@ -133,10 +144,16 @@ std::string HuffmanTree::decodeHelper(const std::string& encoded, int& pos, std:
     }
 }
 
+char HuffmanTree::decodeSymbol(const std::string& encoded, int& pos) const {
+    if (!root) throw std::runtime_error("Tree not built");
+    return decodeHelper(encoded, pos, root)[0];
+}
+
 std::string HuffmanTree::decode(const std::string& encoded) const {
     if (!root) throw std::runtime_error("Tree not built");
     if (encoded.empty()) return "";
 
+    ScopedPhase phase("decode");
     std::string decoded;
     int pos = 0;
     
@@ -228,6 +245,22 @@ bool HuffmanTree::saveTreeToFile(const std::string& filename) const {
     std::ofstream file(filename, std::ios::binary);
     if (!file.is_open()) return false;
 
+    bool saved = saveTree(file);
+    file.close();
+    return saved;
+}
+
+bool HuffmanTree::loadTreeFromFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    bool loaded = loadTree(file);
+    file.close();
+    return loaded;
+}
+
+bool HuffmanTree::saveTree(std::ostream& file) const {
+    ScopedPhase phase("tree_save");
     try {
         // Save the actual tree structure to preserve exact encoding
         serializeTree(file, root);
@@ -241,17 +274,14 @@ bool HuffmanTree::saveTreeToFile(const std::string& filename) const {
             file.write(reinterpret_cast<const char*>(&pair.second), sizeof(int));
         }
 
-        file.close();
-        return true;
+        return static_cast<bool>(file);
     } catch (...) {
         return false;
     }
 }
 
-bool HuffmanTree::loadTreeFromFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) return false;
-
+bool HuffmanTree::loadTree(std::istream& file) {
+    ScopedPhase phase("tree_load");
     try {
         // First, try to deserialize the tree structure
         root = deserializeTree(file);
@@ -259,6 +289,7 @@ bool HuffmanTree::loadTreeFromFile(const std::string& filename) {
         // Read frequency map size
         size_t freqSize;
         file.read(reinterpret_cast<char*>(&freqSize), sizeof(freqSize));
+        if (!file) return false;
 
         // Read frequency data
         frequencies.clear();
@@ -267,6 +298,7 @@ bool HuffmanTree::loadTreeFromFile(const std::string& filename) {
             int freq;
             file.read(&ch, sizeof(char));
             file.read(reinterpret_cast<char*>(&freq), sizeof(int));
+            if (!file) return false;
             frequencies[ch] = freq;
         }
 
@@ -279,7 +311,6 @@ bool HuffmanTree::loadTreeFromFile(const std::string& filename) {
             buildCodes(root, "");
         }
 
-        file.close();
         return true;
     } catch (...) {
         return false;
@@ -307,6 +338,44 @@ int HuffmanTree::getTreeHeight() const {
     return calculateHeight(root);
 }
 
+uint64_t HuffmanTree::estimateEncodedBits(const std::unordered_map<char, int>& freqMap) {
+    if (freqMap.empty()) return 0;
+
+    // Single symbol: one bit per occurrence (code "0")
+    if (freqMap.size() == 1) {
+        return static_cast<uint64_t>(freqMap.begin()->second);
+    }
+
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> pq;
+    for (const auto& pair : freqMap) {
+        pq.push(static_cast<uint64_t>(pair.second));
+    }
+
+    uint64_t totalBits = 0;
+    while (pq.size() > 1) {
+        uint64_t a = pq.top(); pq.pop();
+        uint64_t b = pq.top(); pq.pop();
+        totalBits += a + b;
+        pq.push(a + b);
+    }
+    return totalBits;
+}
+
+size_t HuffmanTree::serializedTreeSize(size_t symbolCount) {
+    if (symbolCount == 0) return 0;
+
+    // Leaf: marker + char + freq, internal: marker + freq, null: marker,
+    // followed by the frequency map (count + char/freq pairs)
+    const size_t leafSize = 2 + sizeof(int);
+    const size_t internalSize = 1 + sizeof(int);
+    const size_t mapSize = sizeof(size_t) + symbolCount * (1 + sizeof(int));
+
+    if (symbolCount == 1) {
+        return internalSize + leafSize + 1 + mapSize;
+    }
+    return symbolCount * leafSize + (symbolCount - 1) * internalSize + mapSize;
+}
+
 int HuffmanTree::calculateHeight(std::shared_ptr<Node> node) const {
     if (!node) return -1;
     if (node->isLeaf()) return 0;
@@ -316,7 +385,7 @@ int HuffmanTree::calculateHeight(std::shared_ptr<Node> node) const {
     return 1 + std::max(leftHeight, rightHeight);
 }
 
-void HuffmanTree::serializeTree(std::ofstream& file, std::shared_ptr<Node> node) const {
+void HuffmanTree::serializeTree(std::ostream& file, std::shared_ptr<Node> node) const {
     if (!node) {
         char marker = 0; // Null node marker
         file.write(&marker, sizeof(char));
@@ -337,8 +406,8 @@ void HuffmanTree::serializeTree(std::ofstream& file, std::shared_ptr<Node> node)
     }
 }
 
-std::shared_ptr<Node> HuffmanTree::deserializeTree(std::ifstream& file) {
-    char marker;
+std::shared_ptr<Node> HuffmanTree::deserializeTree(std::istream& file) {
+    char marker = -1;
     file.read(&marker, sizeof(char));
 
     if (marker == 0) {
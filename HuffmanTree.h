@@ -7,6 +7,7 @@
 #include <queue>
 #include <vector>
 #include <fstream>
+#include <cstdint>
 
 struct Node {
     char character;
@@ -77,8 +78,8 @@ private:
     void printTreeHelper(std::shared_ptr<Node> node, const std::string& prefix, bool isLast) const;
     std::string decodeHelper(const std::string& encoded, int& pos, std::shared_ptr<Node> node) const;
     int calculateHeight(std::shared_ptr<Node> node) const;
-    void serializeTree(std::ofstream& file, std::shared_ptr<Node> node) const;
-    std::shared_ptr<Node> deserializeTree(std::ifstream& file);
+    void serializeTree(std::ostream& file, std::shared_ptr<Node> node) const;
+    std::shared_ptr<Node> deserializeTree(std::istream& file);
 
 public:
     HuffmanTree();
@@ -92,6 +93,9 @@ public:
     std::string encode(const std::string& text) const;
     std::string decode(const std::string& encoded) const;
 
+    // Decode a single symbol starting at pos, advancing pos past its code
+    char decodeSymbol(const std::string& encoded, int& pos) const;
+
     // Utility functions
     std::string getCode(char ch) const;
     const std::unordered_map<char, std::string>& getCodes() const;
@@ -105,9 +109,18 @@ public:
     bool saveTreeToFile(const std::string& filename) const;
     bool loadTreeFromFile(const std::string& filename);
 
+    // Stream I/O (same layout as the tree file, for embedding in other formats)
+    bool saveTree(std::ostream& out) const;
+    bool loadTree(std::istream& in);
+
     // Analysis functions
     double getAverageCodeLength() const;
     int getTreeHeight() const;
+
+    // Size prediction without building nodes or encoding: every optimal
+    // Huffman code has the same total cost, the sum of all merge weights
+    static uint64_t estimateEncodedBits(const std::unordered_map<char, int>& freqMap);
+    static size_t serializedTreeSize(size_t symbolCount);
 };
 
 #endif // HUFFMANTREE_H
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "IoRing.h"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define IORING_SUPPORTED 1
+#endif
+
+#if defined(IORING_SUPPORTED)
+
+struct IoRing::Ring {
+    int fd = -1;
+
+    void* sqPtr = MAP_FAILED;
+    size_t sqSize = 0;
+    void* cqPtr = MAP_FAILED;
+    size_t cqSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    bool buffersRegistered = false;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr) munmap(cqPtr, cqSize);
+        if (sqPtr != MAP_FAILED) munmap(sqPtr, sqSize);
+        if (fd >= 0) close(fd);
+    }
+
+    bool setup(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false;
+
+        sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap && cqSize > sqSize) sqSize = cqSize;
+
+        sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqPtr == MAP_FAILED) return false;
+        if (singleMap) {
+            cqPtr = sqPtr;
+        } else {
+            cqPtr = mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqPtr == MAP_FAILED) return false;
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqPtr);
+        char* cq = static_cast<char*>(cqPtr);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // IORING_OP_READ and IORING_OP_WRITE arrived in 5.6, together with the
+    // probe itself; an older kernel sets up a ring but fails every write
+    bool supportsReadWrite() {
+        const unsigned opCount = 256;
+        std::vector<char> storage(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, opCount) != 0) return false;
+
+        for (unsigned op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED}) {
+            if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    void registerBuffers(const std::vector<char*>& buffers, size_t size) {
+        std::vector<iovec> iovecs(buffers.size());
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            iovecs[i].iov_base = buffers[i];
+            iovecs[i].iov_len = size;
+        }
+        // Can fail under a low RLIMIT_MEMLOCK; plain reads into the same buffers still work
+        buffersRegistered = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                                    iovecs.data(), static_cast<unsigned>(iovecs.size())) == 0;
+    }
+
+    void submit(uint8_t opcode, int fileFd, const char* data, size_t length, uint64_t offset,
+                unsigned bufferIndex, uint64_t tag) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fileFd;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->off = offset;
+        sqe->buf_index = static_cast<uint16_t>(bufferIndex);
+        sqe->user_data = tag;
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        while (syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                throw std::runtime_error(std::string("io_uring submit failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    IoCompletion reap() {
+        while (true) {
+            unsigned head = *cqHead;
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = cqes[head & *cqMask];
+                IoCompletion completion = {cqe.user_data, cqe.res};
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return completion;
+            }
+            if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+                throw std::runtime_error(std::string("io_uring wait failed: ") + std::strerror(errno));
+            }
+        }
+    }
+};
+
+#else
+
+struct IoRing::Ring {};
+
+#endif
+
+IoRing::IoRing(unsigned depth, size_t bufferSize, unsigned bufferCount)
+    : bufSize(bufferSize), depth(depth), pendingCount(0) {
+    for (unsigned i = 0; i < bufferCount; ++i) {
+        buffers.push_back(new char[bufferSize]);
+    }
+
+#if defined(IORING_SUPPORTED)
+    std::unique_ptr<Ring> candidate(new Ring());
+    if (candidate->setup(depth) && candidate->supportsReadWrite()) {
+        candidate->registerBuffers(buffers, bufferSize);
+        ring = std::move(candidate);
+    }
+#endif
+}
+
+IoRing::~IoRing() {
+    // Never free buffers the kernel may still be writing into
+    while (pendingCount > 0) {
+        try {
+            wait();
+        } catch (...) {
+            break;
+        }
+    }
+    ring.reset();
+    for (char* buffer : buffers) {
+        delete[] buffer;
+    }
+}
+
+bool IoRing::isAsync() const {
+    return ring != nullptr;
+}
+
+char* IoRing::buffer(unsigned index) {
+    return buffers.at(index);
+}
+
+size_t IoRing::bufferSize() const {
+    return bufSize;
+}
+
+unsigned IoRing::inFlight() const {
+    return pendingCount;
+}
+
+void IoRing::syncTransfer(bool isRead, int fd, char* data, size_t length, uint64_t fileOffset, uint64_t tag) {
+#if defined(_WIN32)
+    (void)isRead; (void)fd; (void)data; (void)length; (void)fileOffset;
+    completed.push_back({tag, -ENOSYS});
+#else
+    ssize_t result = isRead ? pread(fd, data, length, static_cast<off_t>(fileOffset))
+                            : pwrite(fd, data, length, static_cast<off_t>(fileOffset));
+    completed.push_back({tag, result < 0 ? -static_cast<int64_t>(errno) : static_cast<int64_t>(result)});
+#endif
+}
+
+void IoRing::submitRead(int fd, unsigned bufferIndex, size_t bufferOffset, size_t length, uint64_t fileOffset, uint64_t tag) {
+    if (pendingCount >= depth) throw std::logic_error("IoRing queue is full");
+    if (bufferOffset + length > bufSize) throw std::out_of_range("Read exceeds ring buffer");
+
+    char* target = buffers.at(bufferIndex) + bufferOffset;
+    pendingCount++;
+
+#if defined(IORING_SUPPORTED)
+    if (ring) {
+        ring->submit(ring->buffersRegistered ? IORING_OP_READ_FIXED : IORING_OP_READ,
+                     fd, target, length, fileOffset, bufferIndex, tag);
+        return;
+    }
+#endif
+    syncTransfer(true, fd, target, length, fileOffset, tag);
+}
+
+void IoRing::submitWrite(int fd, const char* data, size_t length, uint64_t fileOffset, uint64_t tag) {
+    if (pendingCount >= depth) throw std::logic_error("IoRing queue is full");
+    pendingCount++;
+
+#if defined(IORING_SUPPORTED)
+    if (ring) {
+        ring->submit(IORING_OP_WRITE, fd, data, length, fileOffset, 0, tag);
+        return;
+    }
+#endif
+    syncTransfer(false, fd, const_cast<char*>(data), length, fileOffset, tag);
+}
+
+IoCompletion IoRing::wait() {
+    if (pendingCount == 0) throw std::logic_error("No I/O in flight");
+
+    IoCompletion completion;
+#if defined(IORING_SUPPORTED)
+    if (ring) {
+        completion = ring->reap();
+        pendingCount--;
+        return completion;
+    }
+#endif
+    completion = completed.front();
+    completed.pop_front();
+    pendingCount--;
+    return completion;
+}
@@ -0,0 +1,57 @@
+#ifndef IORING_H
+#define IORING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+struct IoCompletion {
+    uint64_t tag;
+    int64_t result;     // Bytes transferred, or -errno
+};
+
+// Minimal asynchronous file I/O over POSIX file descriptors. On Linux this
+// drives an io_uring instance through raw syscalls (no liburing needed) with a
+// set of registered, reusable read buffers. Where io_uring is unavailable
+// (other systems, kernels before 5.6, seccomp) each request runs synchronously at
+// submit time and completes immediately, so callers keep a single code path.
+class IoRing {
+public:
+    IoRing(unsigned depth, size_t bufferSize, unsigned bufferCount);
+    ~IoRing();
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    bool isAsync() const;
+
+    char* buffer(unsigned index);
+    size_t bufferSize() const;
+
+    // Reads into registered buffer `bufferIndex` starting at bufferOffset
+    void submitRead(int fd, unsigned bufferIndex, size_t bufferOffset, size_t length, uint64_t fileOffset, uint64_t tag);
+
+    // data must stay alive and unchanged until the write completes
+    void submitWrite(int fd, const char* data, size_t length, uint64_t fileOffset, uint64_t tag);
+
+    // Blocks until the next request completes
+    IoCompletion wait();
+
+    unsigned inFlight() const;
+
+private:
+    struct Ring;
+
+    std::unique_ptr<Ring> ring;          // Null when running synchronously
+    std::vector<char*> buffers;
+    size_t bufSize;
+    unsigned depth;
+    unsigned pendingCount;
+    std::deque<IoCompletion> completed;  // Synchronous-mode results
+
+    void syncTransfer(bool isRead, int fd, char* data, size_t length, uint64_t fileOffset, uint64_t tag);
+};
+
+#endif // IORING_H
@@ -0,0 +1,516 @@
+#include "LZ77.h"
+#include "HuffmanTree.h"
+#include "BinaryIO.h"
+#include "Stats.h"
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <algorithm>
+
+// Index 0 is unused so levels map directly onto the table
+const LZ77::LevelConfig LZ77::LEVELS[LZ77::MAX_LEVEL + 1] = {
+    {0, 0, false, false},
+    {4, 8, false, false},
+    {8, 16, false, false},
+    {16, 32, false, false},
+    {16, 32, true, false},
+    {32, 32, true, false},
+    {128, 48, true, false},
+    {256, 48, true, false},
+    {1024, 258, true, true},
+    {4096, 258, true, true}
+};
+
+namespace {
+
+const int HASH_BITS = 15;
+const int HASH_SIZE = 1 << HASH_BITS;
+
+// Presence flags for the optional tables in a payload
+const uint8_t HAS_LITERALS = 1;
+const uint8_t HAS_LENGTHS = 2;
+const uint8_t HAS_DISTANCES = 4;
+
+struct Match {
+    int length;
+    int distance;
+};
+
+// Hash-chain match finder over a single input buffer
+class MatchFinder {
+public:
+    MatchFinder(const std::string& text, int maxChain, int niceLength)
+        : text(text), head(HASH_SIZE, -1), prev(text.length(), -1),
+          nextInsert(0), maxChain(maxChain), niceLength(niceLength) {}
+
+    Match find(int pos) {
+        insertUpTo(pos);
+
+        Match best = {0, 0};
+        int n = static_cast<int>(text.length());
+        if (pos + LZ77::MIN_MATCH > n) return best;
+
+        int maxLength = std::min(LZ77::MAX_MATCH, n - pos);
+        int candidate = head[hash(pos)];
+        int chain = maxChain;
+
+        while (candidate >= 0 && pos - candidate <= LZ77::WINDOW_SIZE && chain-- > 0) {
+            // Quick reject: the byte that would extend the best match must agree
+            if (text[candidate + best.length] == text[pos + best.length]) {
+                int length = 0;
+                while (length < maxLength && text[candidate + length] == text[pos + length]) {
+                    length++;
+                }
+                if (length > best.length) {
+                    best.length = length;
+                    best.distance = pos - candidate;
+                    if (length >= niceLength || length == maxLength) break;
+                }
+            }
+            candidate = prev[candidate];
+        }
+
+        if (best.length < LZ77::MIN_MATCH) best.length = 0;
+        return best;
+    }
+
+private:
+    const std::string& text;
+    std::vector<int> head;
+    std::vector<int> prev;
+    int nextInsert;
+    int maxChain;
+    int niceLength;
+
+    int hash(int pos) const {
+        unsigned int h = (static_cast<unsigned char>(text[pos]) << 10)
+                       ^ (static_cast<unsigned char>(text[pos + 1]) << 5)
+                       ^ static_cast<unsigned char>(text[pos + 2]);
+        return static_cast<int>((h * 2654435761u) >> (32 - HASH_BITS));
+    }
+
+    // Positions are only visible to find() once everything before them is inserted
+    void insertUpTo(int pos) {
+        int last = static_cast<int>(text.length()) - LZ77::MIN_MATCH;
+        while (nextInsert < pos && nextInsert <= last) {
+            int h = hash(nextInsert);
+            prev[nextInsert] = head[h];
+            head[h] = nextInsert;
+            nextInsert++;
+        }
+        if (nextInsert < pos) nextInsert = pos;
+    }
+};
+
+// Lengths and distances are coded as a bucket symbol plus raw extra bits:
+// values below 16 are their own symbol, larger values use 12 + floor(log2(v))
+void bucketize(uint32_t value, char& symbol, int& extraBits, uint32_t& extra) {
+    if (value < 16) {
+        symbol = static_cast<char>(value);
+        extraBits = 0;
+        extra = 0;
+        return;
+    }
+
+    int log2 = 0;
+    while ((value >> (log2 + 1)) != 0) log2++;
+
+    symbol = static_cast<char>(12 + log2);
+    extraBits = log2;
+    extra = value - (1u << log2);
+}
+
+void appendValue(std::string& bits, const std::unordered_map<char, std::string>& codes, uint32_t value) {
+    char symbol;
+    int extraBits;
+    uint32_t extra;
+    bucketize(value, symbol, extraBits, extra);
+
+    bits += codes.at(symbol);
+    appendBits(bits, extra, extraBits);
+}
+
+uint32_t readValueCode(const std::string& bits, int& pos, const HuffmanTree& tree) {
+    int symbol = static_cast<unsigned char>(tree.decodeSymbol(bits, pos));
+    if (symbol < 16) return static_cast<uint32_t>(symbol);
+
+    int log2 = symbol - 12;
+    if (log2 > 31) throw std::runtime_error("Invalid length code in LZ77 payload");
+    return (1u << log2) + readBits(bits, pos, log2);
+}
+
+void countValue(std::unordered_map<char, int>& freq, uint32_t value) {
+    char symbol;
+    int extraBits;
+    uint32_t extra;
+    bucketize(value, symbol, extraBits, extra);
+    freq[symbol]++;
+}
+
+struct ParseHistograms {
+    std::unordered_map<char, int> literals, lengths, distances;
+    uint64_t extraBits = 0;
+};
+
+ParseHistograms countParse(const LZ77Parse& parsed) {
+    ParseHistograms counts;
+    for (char ch : parsed.literals) {
+        counts.literals[ch]++;
+    }
+
+    char symbol;
+    int extraBits;
+    uint32_t extra;
+    for (const auto& seq : parsed.sequences) {
+        countValue(counts.lengths, seq.literalLength);
+        countValue(counts.lengths, seq.matchLength);
+        bucketize(seq.literalLength, symbol, extraBits, extra);
+        counts.extraBits += extraBits;
+        bucketize(seq.matchLength, symbol, extraBits, extra);
+        counts.extraBits += extraBits;
+        if (seq.matchLength > 0) {
+            countValue(counts.distances, seq.distance - 1);
+            bucketize(seq.distance - 1, symbol, extraBits, extra);
+            counts.extraBits += extraBits;
+        }
+    }
+    return counts;
+}
+
+// Payload size compress() would produce for this parse, without encoding it
+uint64_t codedSize(const LZ77Parse& parsed) {
+    ParseHistograms counts = countParse(parsed);
+    uint64_t bits = HuffmanTree::estimateEncodedBits(counts.literals) + HuffmanTree::estimateEncodedBits(counts.lengths)
+                  + HuffmanTree::estimateEncodedBits(counts.distances) + counts.extraBits;
+    return sizeof(uint32_t) + sizeof(uint8_t) + HuffmanTree::serializedTreeSize(counts.literals.size())
+         + HuffmanTree::serializedTreeSize(counts.lengths.size()) + HuffmanTree::serializedTreeSize(counts.distances.size())
+         + sizeof(uint64_t) + (bits + 7) / 8;
+}
+
+// Bit cost of each symbol under the codes an earlier parse would get.
+// Symbols that parse never used are priced a little above its longest code.
+class Prices {
+public:
+    explicit Prices(const LZ77Parse& parsed) {
+        ParseHistograms counts = countParse(parsed);
+        fill(literals, counts.literals);
+        fill(lengths, counts.lengths);
+        fill(distances, counts.distances);
+
+        // Every match starts a sequence, whose literal run length is coded too
+        uint64_t runBits = 0;
+        for (const auto& seq : parsed.sequences) {
+            runBits += valuePrice(lengths, seq.literalLength);
+        }
+        sequence = parsed.sequences.empty() ? 0 : static_cast<int>(runBits / parsed.sequences.size());
+    }
+
+    int literal(char ch) const { return literals[static_cast<unsigned char>(ch)]; }
+    int match(int length, int distance) const {
+        return sequence + valuePrice(lengths, length) + valuePrice(distances, distance - 1);
+    }
+
+private:
+    int literals[256];
+    int lengths[256];
+    int distances[256];
+    int sequence;
+
+    static void fill(int (&prices)[256], const std::unordered_map<char, int>& freq) {
+        std::fill(prices, prices + 256, 0);
+        int longest = 0;
+        if (freq.size() > 1) {
+            HuffmanTree tree;
+            tree.buildTree(freq);
+            for (const auto& pair : tree.getCodes()) {
+                int length = static_cast<int>(pair.second.length());
+                prices[static_cast<unsigned char>(pair.first)] = length;
+                longest = std::max(longest, length);
+            }
+        } else if (freq.size() == 1) {
+            prices[static_cast<unsigned char>(freq.begin()->first)] = longest = 1;
+        }
+        for (int& price : prices) {
+            if (price == 0) price = longest + 2;
+        }
+    }
+
+    static int valuePrice(const int (&prices)[256], uint32_t value) {
+        char symbol;
+        int extraBits;
+        uint32_t extra;
+        bucketize(value, symbol, extraBits, extra);
+        return prices[static_cast<unsigned char>(symbol)] + extraBits;
+    }
+};
+
+// Shortest path through the text where each step is a literal or a prefix of
+// the longest match at its position, weighed by prices
+LZ77Parse pricedParse(const std::string& text, int maxChain, int niceLength, const Prices& prices) {
+    MatchFinder finder(text, maxChain, niceLength);
+    int n = static_cast<int>(text.length());
+
+    // Cheapest known cost of reaching each position, and the step that got
+    // there (length 0 for a literal)
+    std::vector<uint64_t> cost(n + 1, UINT64_MAX);
+    std::vector<Match> step(n + 1, Match{0, 0});
+    cost[0] = 0;
+
+    // A match minus its first byte is a match at the next position; while
+    // that is still long, it stands in for a new search
+    const int carryLength = 32;
+    Match carried = {0, 0};
+
+    for (int pos = 0; pos < n; ++pos) {
+        if (cost[pos] + prices.literal(text[pos]) < cost[pos + 1]) {
+            cost[pos + 1] = cost[pos] + prices.literal(text[pos]);
+            step[pos + 1] = Match{0, 0};
+        }
+
+        Match match = carried.length > carryLength ? Match{carried.length - 1, carried.distance} : finder.find(pos);
+        carried = match;
+        auto relax = [&](int length) {
+            uint64_t total = cost[pos] + prices.match(length, match.distance);
+            if (total < cost[pos + length]) {
+                cost[pos + length] = total;
+                step[pos + length] = Match{length, match.distance};
+            }
+        };
+        if (match.length >= niceLength) {
+            // Long enough to take whole; the positions it covers are not searched
+            relax(match.length);
+            pos += match.length - 1;
+            carried = Match{0, 0};
+            continue;
+        }
+        for (int length = LZ77::MIN_MATCH; length <= std::min(match.length, 15); ++length) {
+            relax(length);
+        }
+        // From 16 up a length costs the same across its power of two, so only
+        // the longest of each bucket and the match itself are tried
+        for (int length = 31; length < match.length; length = length * 2 + 1) {
+            relax(length);
+        }
+        if (match.length > 15) relax(match.length);
+    }
+
+    std::vector<Match> path;
+    for (int pos = n; pos > 0; pos -= std::max(step[pos].length, 1)) {
+        path.push_back(step[pos]);
+    }
+
+    LZ77Parse result;
+    int pos = 0;
+    int literalStart = 0;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        if (it->length == 0) {
+            pos++;
+            continue;
+        }
+        result.literals.append(text, literalStart, pos - literalStart);
+        result.sequences.emplace_back(pos - literalStart, it->length, it->distance);
+        pos += it->length;
+        literalStart = pos;
+    }
+    if (literalStart < n) {
+        result.literals.append(text, literalStart, n - literalStart);
+        result.sequences.emplace_back(n - literalStart, 0, 0);
+    }
+    return result;
+}
+
+} // namespace
+
+LZ77::LZ77(int level) {
+    if (level < MIN_LEVEL || level > MAX_LEVEL) {
+        throw std::invalid_argument("LZ77 level must be between 1 and 9");
+    }
+    this->level = level;
+    config = LEVELS[level];
+}
+
+int LZ77::getLevel() const {
+    return level;
+}
+
+LZ77Parse LZ77::parse(const std::string& text) const {
+    ScopedPhase phase("match_find");
+    LZ77Parse result = lazyParse(text);
+    if (!config.priced) return result;
+
+    // The longest match is not always the cheapest: a byte more can cost a
+    // far distance, and deferring for it costs a literal. Re-parse with the
+    // bit prices of the first parse and keep whichever codes smaller.
+    LZ77Parse priced = pricedParse(text, config.maxChain, config.niceLength, Prices(result));
+    if (codedSize(priced) < codedSize(result)) {
+        result = std::move(priced);
+    }
+    return result;
+}
+
+LZ77Parse LZ77::lazyParse(const std::string& text) const {
+    LZ77Parse result;
+    MatchFinder finder(text, config.maxChain, config.niceLength);
+
+    int n = static_cast<int>(text.length());
+    int pos = 0;
+    int literalStart = 0;
+
+    // A lookahead match found by lazy evaluation, reused on the next iteration
+    bool havePending = false;
+    Match pending = {0, 0};
+
+    while (pos < n) {
+        Match match = havePending ? pending : finder.find(pos);
+        havePending = false;
+
+        if (match.length == 0) {
+            pos++;
+            continue;
+        }
+
+        // Lazy evaluation: emit a literal instead if the next position matches longer
+        if (config.lazy && match.length < config.niceLength && pos + 1 < n) {
+            Match next = finder.find(pos + 1);
+            if (next.length > match.length) {
+                pending = next;
+                havePending = true;
+                pos++;
+                continue;
+            }
+        }
+
+        result.literals.append(text, literalStart, pos - literalStart);
+        result.sequences.emplace_back(pos - literalStart, match.length, match.distance);
+
+        pos += match.length;
+        literalStart = pos;
+    }
+
+    if (literalStart < n) {
+        result.literals.append(text, literalStart, n - literalStart);
+        result.sequences.emplace_back(n - literalStart, 0, 0);
+    }
+
+    return result;
+}
+
+std::string LZ77::expand(const LZ77Parse& parsed) {
+    std::string output;
+    size_t literalPos = 0;
+
+    for (const auto& seq : parsed.sequences) {
+        if (literalPos + seq.literalLength > parsed.literals.length()) {
+            throw std::runtime_error("LZ77 sequence exceeds literal buffer");
+        }
+        output.append(parsed.literals, literalPos, seq.literalLength);
+        literalPos += seq.literalLength;
+
+        if (seq.matchLength == 0) continue;
+        if (seq.distance == 0 || seq.distance > output.length()) {
+            throw std::runtime_error("Invalid LZ77 match distance");
+        }
+
+        // Byte-by-byte copy so overlapping matches repeat correctly
+        size_t from = output.length() - seq.distance;
+        for (uint32_t i = 0; i < seq.matchLength; ++i) {
+            output += output[from + i];
+        }
+    }
+
+    return output;
+}
+
+std::string LZ77::compress(const std::string& text) const {
+    LZ77Parse parsed = parse(text);
+
+    ParseHistograms counts = countParse(parsed);
+    const auto& literalFreq = counts.literals;
+    const auto& lengthFreq = counts.lengths;
+    const auto& distanceFreq = counts.distances;
+
+    HuffmanTree literalTree, lengthTree, distanceTree;
+    uint8_t tables = 0;
+    if (!literalFreq.empty()) { literalTree.buildTree(literalFreq); tables |= HAS_LITERALS; }
+    if (!lengthFreq.empty()) { lengthTree.buildTree(lengthFreq); tables |= HAS_LENGTHS; }
+    if (!distanceFreq.empty()) { distanceTree.buildTree(distanceFreq); tables |= HAS_DISTANCES; }
+
+    if ((tables & HAS_LITERALS) && Stats::global().isEnabled()) {
+        Stats::global().recordTree(literalFreq.size(), literalTree.getTreeHeight(),
+                                   literalTree.getAverageCodeLength(), parsed.literals.length());
+    }
+
+    const auto& literalCodes = literalTree.getCodes();
+    const auto& lengthCodes = lengthTree.getCodes();
+    const auto& distanceCodes = distanceTree.getCodes();
+
+    ScopedPhase phase("encode");
+    std::string bits;
+    size_t literalPos = 0;
+    for (const auto& seq : parsed.sequences) {
+        appendValue(bits, lengthCodes, seq.literalLength);
+        for (uint32_t i = 0; i < seq.literalLength; ++i) {
+            bits += literalCodes.at(parsed.literals[literalPos++]);
+        }
+        appendValue(bits, lengthCodes, seq.matchLength);
+        if (seq.matchLength > 0) {
+            appendValue(bits, distanceCodes, seq.distance - 1);
+        }
+    }
+
+    std::ostringstream out(std::ios::binary);
+    writeValue<uint32_t>(out, static_cast<uint32_t>(parsed.sequences.size()));
+    writeValue<uint8_t>(out, tables);
+    if ((tables & HAS_LITERALS) && !literalTree.saveTree(out)) throw std::runtime_error("Failed to write literal table");
+    if ((tables & HAS_LENGTHS) && !lengthTree.saveTree(out)) throw std::runtime_error("Failed to write length table");
+    if ((tables & HAS_DISTANCES) && !distanceTree.saveTree(out)) throw std::runtime_error("Failed to write distance table");
+    writeValue<uint64_t>(out, bits.length());
+    out << packBits(bits);
+
+    return out.str();
+}
+
+std::string LZ77::decompress(const std::string& payload) {
+    std::istringstream in(payload, std::ios::binary);
+
+    uint32_t sequenceCount = readValue<uint32_t>(in);
+    uint8_t tables = readValue<uint8_t>(in);
+
+    HuffmanTree literalTree, lengthTree, distanceTree;
+    if ((tables & HAS_LITERALS) && !literalTree.loadTree(in)) throw std::runtime_error("Invalid literal table");
+    if ((tables & HAS_LENGTHS) && !lengthTree.loadTree(in)) throw std::runtime_error("Invalid length table");
+    if ((tables & HAS_DISTANCES) && !distanceTree.loadTree(in)) throw std::runtime_error("Invalid distance table");
+
+    uint64_t bitCount = readValue<uint64_t>(in);
+    std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string bits = unpackBits(packed, bitCount);
+
+    ScopedPhase phase("decode");
+    std::string output;
+    int pos = 0;
+    for (uint32_t s = 0; s < sequenceCount; ++s) {
+        uint32_t literalLength = readValueCode(bits, pos, lengthTree);
+        for (uint32_t i = 0; i < literalLength; ++i) {
+            output += literalTree.decodeSymbol(bits, pos);
+        }
+
+        uint32_t matchLength = readValueCode(bits, pos, lengthTree);
+        if (matchLength == 0) continue;
+
+        uint32_t distance = readValueCode(bits, pos, distanceTree) + 1;
+        if (distance > output.length()) {
+            throw std::runtime_error("Invalid LZ77 match distance");
+        }
+
+        size_t from = output.length() - distance;
+        for (uint32_t i = 0; i < matchLength; ++i) {
+            output += output[from + i];
+        }
+    }
+
+    if (pos != static_cast<int>(bits.length())) {
+        throw std::runtime_error("Invalid encoded string: extra bits remaining");
+    }
+
+    return output;
+}
@@ -0,0 +1,63 @@
+#ifndef LZ77_H
+#define LZ77_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// One parsed step: literalLength raw bytes followed by a back-reference
+struct LZ77Sequence {
+    uint32_t literalLength;
+    uint32_t matchLength;   // 0 for a trailing literal-only sequence
+    uint32_t distance;
+
+    LZ77Sequence(uint32_t litLen, uint32_t matchLen, uint32_t dist)
+        : literalLength(litLen), matchLength(matchLen), distance(dist) {}
+};
+
+struct LZ77Parse {
+    std::string literals;                 // All literal bytes, in order
+    std::vector<LZ77Sequence> sequences;
+};
+
+class LZ77 {
+public:
+    static constexpr int MIN_LEVEL = 1;
+    static constexpr int MAX_LEVEL = 9;
+    static constexpr int DEFAULT_LEVEL = 6;
+
+    static constexpr int WINDOW_SIZE = 32768;
+    static constexpr int MIN_MATCH = 3;
+    static constexpr int MAX_MATCH = 258;
+
+    explicit LZ77(int level = DEFAULT_LEVEL);
+
+    // Match finding
+    LZ77Parse parse(const std::string& text) const;
+    static std::string expand(const LZ77Parse& parsed);
+
+    // Entropy-coded payload: literals, lengths and distances are each
+    // coded with their own HuffmanTree, DEFLATE-style
+    std::string compress(const std::string& text) const;
+    static std::string decompress(const std::string& payload);
+
+    int getLevel() const;
+
+private:
+    struct LevelConfig {
+        int maxChain;     // Hash chain entries examined per position
+        int niceLength;   // Stop searching once a match this long is found
+        bool lazy;        // Defer a match if the next position has a longer one
+        bool priced;      // Also parse by bit cost and keep the smaller parse
+    };
+
+    static const LevelConfig LEVELS[MAX_LEVEL + 1];
+
+    int level;
+    LevelConfig config;
+
+    // Greedy parse with optional one-step lazy matching
+    LZ77Parse lazyParse(const std::string& text) const;
+};
+
+#endif // LZ77_H
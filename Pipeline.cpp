@@ -0,0 +1,401 @@
+#include "Pipeline.h"
+#include "IoRing.h"
+#include "Search.h"
+#include "Stats.h"
+#include <stdexcept>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum SlotState {
+    SLOT_FREE,
+    SLOT_READING,
+    SLOT_READY
+};
+
+// One registered read buffer
+struct ReadSlot {
+    SlotState state = SLOT_FREE;
+    uint64_t offset = 0;
+    size_t length = 0;
+    size_t filled = 0;
+};
+
+// Owns the bytes of one write until the kernel is done with them
+struct WriteSlot {
+    bool busy = false;
+    std::string data;
+    uint64_t offset = 0;
+    size_t written = 0;
+};
+
+uint64_t readTag(unsigned slot) { return static_cast<uint64_t>(slot) << 1; }
+uint64_t writeTag(unsigned slot) { return (static_cast<uint64_t>(slot) << 1) | 1; }
+
+#if !defined(_WIN32)
+
+class FileHandle {
+public:
+    explicit FileHandle(int fd) : fd(fd) {}
+    ~FileHandle() { if (fd >= 0) close(fd); }
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    int fd;
+};
+
+// Removes a partly written output unless the operation got to the end
+class OutputGuard {
+public:
+    explicit OutputGuard(const std::string& path) : path(path), complete(false) {}
+    ~OutputGuard() { if (!complete) unlink(path.c_str()); }
+    OutputGuard(const OutputGuard&) = delete;
+    OutputGuard& operator=(const OutputGuard&) = delete;
+
+    void commit() { complete = true; }
+
+private:
+    std::string path;
+    bool complete;
+};
+
+// O_TRUNC on the output would empty the input before it is read
+void checkDistinct(int inputFd, const std::string& outputPath) {
+    struct stat input, output;
+    if (fstat(inputFd, &input) == 0 && stat(outputPath.c_str(), &output) == 0 &&
+        input.st_dev == output.st_dev && input.st_ino == output.st_ino) {
+        throw std::runtime_error("Input and output are the same file");
+    }
+}
+
+uint64_t fileSize(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        throw std::runtime_error(std::string("Cannot stat input file: ") + std::strerror(errno));
+    }
+    return static_cast<uint64_t>(info.st_size);
+}
+
+#endif
+
+// Shared bookkeeping for both directions: resubmits short transfers and
+// releases slots as their I/O completes
+class SlotRing {
+public:
+    SlotRing(int inputFd, int outputFd, size_t bufferSize)
+        : reads(Pipeline::DEPTH), writes(Pipeline::DEPTH), ring(2 * Pipeline::DEPTH, bufferSize, Pipeline::DEPTH),
+          inputFd(inputFd), outputFd(outputFd), nextWrite(0) {}
+
+    std::vector<ReadSlot> reads;
+    std::vector<WriteSlot> writes;
+    IoRing ring;   // Declared last: its destructor waits for writes from the slots above
+
+    void startRead(unsigned slot, uint64_t offset, size_t length) {
+        ReadSlot& read = reads[slot];
+        read.state = SLOT_READING;
+        read.offset = offset;
+        read.length = length;
+        read.filled = 0;
+        submitRead(slot);
+    }
+
+    // Writes go out in submission order through round-robin slots
+    bool writeSlotFree() const {
+        return !writes[nextWrite].busy;
+    }
+
+    void startWrite(std::string data, uint64_t offset) {
+        WriteSlot& write = writes[nextWrite];
+        write.busy = true;
+        write.data = std::move(data);
+        write.offset = offset;
+        write.written = 0;
+        submitWrite(nextWrite);
+        nextWrite = (nextWrite + 1) % Pipeline::DEPTH;
+    }
+
+    // Waits for one completion; false when nothing is in flight
+    bool completeOne() {
+        if (ring.inFlight() == 0) return false;
+
+        IoCompletion completion;
+        {
+            ScopedPhase phase("io_wait");
+            completion = ring.wait();
+        }
+        unsigned slot = static_cast<unsigned>(completion.tag >> 1);
+        bool isWrite = (completion.tag & 1) != 0;
+
+        if (completion.result < 0) {
+            throw std::runtime_error(std::string(isWrite ? "Write failed: " : "Read failed: ") +
+                                     std::strerror(static_cast<int>(-completion.result)));
+        }
+
+        if (isWrite) {
+            WriteSlot& write = writes[slot];
+            if (completion.result == 0) throw std::runtime_error("Write failed: no progress");
+            write.written += static_cast<size_t>(completion.result);
+            if (write.written < write.data.length()) {
+                submitWrite(slot);
+            } else {
+                write.busy = false;
+            }
+        } else {
+            ReadSlot& read = reads[slot];
+            if (completion.result == 0) throw std::runtime_error("Input file changed size while reading");
+            read.filled += static_cast<size_t>(completion.result);
+            if (read.filled < read.length) {
+                submitRead(slot);
+            } else {
+                read.state = SLOT_READY;
+            }
+        }
+        return true;
+    }
+
+    void drain() {
+        while (completeOne()) {
+        }
+    }
+
+private:
+    int inputFd;
+    int outputFd;
+    unsigned nextWrite;
+
+    void submitRead(unsigned slot) {
+        const ReadSlot& read = reads[slot];
+        ring.submitRead(inputFd, slot, read.filled, read.length - read.filled, read.offset + read.filled, readTag(slot));
+    }
+
+    void submitWrite(unsigned slot) {
+        const WriteSlot& write = writes[slot];
+        ring.submitWrite(outputFd, write.data.data() + write.written, write.data.length() - write.written,
+                         write.offset + write.written, writeTag(slot));
+    }
+};
+
+} // namespace
+
+#if defined(_WIN32)
+
+bool Pipeline::isSupported() {
+    return false;
+}
+
+PipelineResult Pipeline::compressFile(const std::string&, const std::string&, const CompressOptions&) {
+    throw std::runtime_error("Pipelined I/O is not supported on this platform");
+}
+
+PipelineResult Pipeline::decompressFile(const std::string&, const std::string&) {
+    throw std::runtime_error("Pipelined I/O is not supported on this platform");
+}
+
+#else
+
+bool Pipeline::isSupported() {
+    return true;
+}
+
+PipelineResult Pipeline::compressFile(const std::string& inputPath, const std::string& outputPath,
+                                      const CompressOptions& options) {
+    if (options.blockSize == 0) {
+        throw std::invalid_argument("Block size must be positive");
+    }
+    if (options.dedup) {
+        throw std::invalid_argument("Dedup matches against the whole input; use Compressor::compress");
+    }
+
+    FileHandle input(open(inputPath.c_str(), O_RDONLY));
+    if (input.fd < 0) throw std::runtime_error("Cannot open input file");
+    uint64_t inputSize = fileSize(input.fd);
+    checkDistinct(input.fd, outputPath);
+
+    FileHandle output(open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+    if (output.fd < 0) throw std::runtime_error("Cannot create output file");
+    OutputGuard guard(outputPath);
+
+    SlotRing slots(input.fd, output.fd, options.blockSize);
+    slots.startWrite(std::string(Compressor::MAGIC, sizeof(Compressor::MAGIC)), 0);
+
+    uint64_t blockCount = (inputSize + options.blockSize - 1) / options.blockSize;
+    uint64_t nextRead = 0, nextEncode = 0;
+    uint64_t writeOffset = sizeof(Compressor::MAGIC);
+    std::vector<BlockIndexEntry> index;
+    std::vector<BlockFilter> filters;
+
+    while (nextEncode < blockCount) {
+        // Keep every free buffer busy reading ahead
+        while (nextRead < blockCount && slots.reads[nextRead % DEPTH].state == SLOT_FREE) {
+            uint64_t offset = nextRead * options.blockSize;
+            size_t length = static_cast<size_t>(std::min<uint64_t>(options.blockSize, inputSize - offset));
+            slots.startRead(static_cast<unsigned>(nextRead % DEPTH), offset, length);
+            nextRead++;
+        }
+
+        unsigned slot = static_cast<unsigned>(nextEncode % DEPTH);
+        ReadSlot& read = slots.reads[slot];
+        if (read.state != SLOT_READY || !slots.writeSlotFree()) {
+            slots.completeOne();
+            continue;
+        }
+
+        std::vector<BlockHeader> headers;
+        std::string framed = Compressor::frameBlocks(std::string(slots.ring.buffer(slot), read.length), options, headers);
+        uint64_t rawOffset = read.offset, fileOffset = writeOffset;
+        for (const BlockHeader& header : headers) {
+            index.push_back({rawOffset, fileOffset, header.rawSize});
+            if (options.searchable) {
+                filters.push_back(BlockFilter::build(slots.ring.buffer(slot) + (rawOffset - read.offset), header.rawSize));
+            }
+            rawOffset += header.rawSize;
+            fileOffset += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+        }
+        read.state = SLOT_FREE;
+
+        uint64_t offset = writeOffset;
+        writeOffset += framed.length();
+        slots.startWrite(std::move(framed), offset);
+        nextEncode++;
+    }
+
+    if (!filters.empty()) {
+        while (!slots.writeSlotFree()) slots.completeOne();
+        std::string framed = Compressor::frameFilters(filters);
+        uint64_t offset = writeOffset;
+        writeOffset += framed.length();
+        slots.startWrite(std::move(framed), offset);
+    }
+    if (options.seekable) {
+        while (!slots.writeSlotFree()) slots.completeOne();
+        std::string trailer = Compressor::frameIndex(index);
+        uint64_t offset = writeOffset;
+        writeOffset += trailer.length();
+        slots.startWrite(std::move(trailer), offset);
+    }
+    slots.drain();
+    guard.commit();
+
+    PipelineResult result;
+    result.inputBytes = inputSize;
+    result.outputBytes = writeOffset;
+    result.async = slots.ring.isAsync();
+    return result;
+}
+
+PipelineResult Pipeline::decompressFile(const std::string& inputPath, const std::string& outputPath) {
+    FileHandle input(open(inputPath.c_str(), O_RDONLY));
+    if (input.fd < 0) throw std::runtime_error("Cannot open encoded file");
+    uint64_t inputSize = fileSize(input.fd);
+    checkDistinct(input.fd, outputPath);
+
+    // Readable too: copy blocks repeat bytes already written
+    FileHandle output(open(outputPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+    if (output.fd < 0) throw std::runtime_error("Cannot create output file");
+    OutputGuard guard(outputPath);
+
+    SlotRing slots(input.fd, output.fd, READ_CHUNK_SIZE);
+
+    DecodeContext context;
+    std::ifstream container(inputPath, std::ios::binary);
+    context.container = &container;
+    context.history = [&](uint64_t offset, uint64_t length) {
+        slots.drain();
+        std::string bytes(length, '\0');
+        for (size_t done = 0; done < length;) {
+            ssize_t got = pread(output.fd, &bytes[done], length - done, static_cast<off_t>(offset + done));
+            if (got <= 0) throw std::runtime_error("Copy block refers to data not yet decoded");
+            done += static_cast<size_t>(got);
+        }
+        return bytes;
+    };
+
+    uint64_t chunkCount = (inputSize + READ_CHUNK_SIZE - 1) / READ_CHUNK_SIZE;
+    uint64_t nextRead = 0, nextConsume = 0;
+    uint64_t writeOffset = 0;
+    size_t blockIndex = 0;
+    bool magicChecked = false;
+    bool ended = false;
+
+    // Chunks are consumed in file order; framed blocks may span chunk boundaries
+    std::string pending;
+    size_t pos = 0;
+
+    while (true) {
+        while (!ended && nextRead < chunkCount && slots.reads[nextRead % DEPTH].state == SLOT_FREE) {
+            uint64_t offset = nextRead * READ_CHUNK_SIZE;
+            size_t length = static_cast<size_t>(std::min<uint64_t>(READ_CHUNK_SIZE, inputSize - offset));
+            slots.startRead(static_cast<unsigned>(nextRead % DEPTH), offset, length);
+            nextRead++;
+        }
+
+        unsigned slot = static_cast<unsigned>(nextConsume % DEPTH);
+        if (ended || nextConsume == chunkCount || slots.reads[slot].state != SLOT_READY) {
+            if (!slots.completeOne()) break;
+            continue;
+        }
+
+        pending.append(slots.ring.buffer(slot), slots.reads[slot].length);
+        slots.reads[slot].state = SLOT_FREE;
+        nextConsume++;
+
+        if (!magicChecked) {
+            if (pending.length() < sizeof(Compressor::MAGIC)) continue;
+            if (!Compressor::isCompressed(pending)) {
+                throw std::runtime_error("Not a compressed file (bad magic)");
+            }
+            pos = sizeof(Compressor::MAGIC);
+            magicChecked = true;
+        }
+
+        BlockHeader header;
+        while (pos < pending.length()) {
+            if (static_cast<uint8_t>(pending[pos]) == BLOCK_INDEX) {
+                ended = true;
+                break;
+            }
+            size_t framedSize = Compressor::framedBlockSize(pending.data() + pos, pending.length() - pos, header);
+            if (framedSize == 0) break;
+
+            while (!slots.writeSlotFree()) slots.completeOne();
+
+            std::string payload = pending.substr(pos + framedSize - header.payloadSize, header.payloadSize);
+            std::string block = Compressor::decodeVerified(header, payload, blockIndex++, context);
+            pos += framedSize;
+            if (block.empty()) continue;
+
+            uint64_t offset = writeOffset;
+            writeOffset += block.length();
+            slots.startWrite(std::move(block), offset);
+        }
+
+        pending.erase(0, pos);
+        pos = 0;
+    }
+
+    if (!magicChecked) {
+        throw std::runtime_error("Not a compressed file (bad magic)");
+    }
+    if (!ended && !pending.empty()) {
+        throw std::runtime_error("Truncated block payload");
+    }
+    guard.commit();
+
+    PipelineResult result;
+    result.inputBytes = inputSize;
+    result.outputBytes = writeOffset;
+    result.async = slots.ring.isAsync();
+    return result;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "Compressor.h"
+#include <string>
+#include <cstdint>
+
+struct PipelineResult {
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    bool async = false;     // True when io_uring carried the I/O
+};
+
+// File-to-file compress/decompress that overlaps reading block N+1 and
+// writing block N-1 with coding block N, keeping only a few blocks in memory.
+// Output is byte-identical to Compressor::compress / decompress.
+class Pipeline {
+public:
+    static constexpr unsigned DEPTH = 4;                   // Blocks in flight per direction
+    static constexpr size_t READ_CHUNK_SIZE = 1 << 20;     // Read size when decompressing
+
+    // False where the pipeline has no file backend (Windows); use Compressor directly there
+    static bool isSupported();
+
+    // options.dedup is not supported here: it needs the whole input in memory
+    static PipelineResult compressFile(const std::string& inputPath, const std::string& outputPath,
+                                       const CompressOptions& options = CompressOptions());
+    static PipelineResult decompressFile(const std::string& inputPath, const std::string& outputPath);
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,247 @@
+#include "Search.h"
+#include "Compressor.h"
+#include "BinaryIO.h"
+#include "Stats.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+namespace {
+
+// murmur3 finalizer; pairs and triples get distinct tags so they never collide by value
+uint32_t gramHash(uint32_t gram) {
+    gram ^= gram >> 16;
+    gram *= 0x85ebca6bu;
+    gram ^= gram >> 13;
+    gram *= 0xc2b2ae35u;
+    gram ^= gram >> 16;
+    return gram;
+}
+
+uint32_t pairAt(const unsigned char* text, size_t i) {
+    return gramHash((1u << 24) | (text[i] << 8) | text[i + 1]);
+}
+
+uint32_t tripleAt(const unsigned char* text, size_t i) {
+    return gramHash((2u << 24) | (text[i] << 16) | (text[i + 1] << 8) | text[i + 2]);
+}
+
+// About one bit per BYTES_PER_GRAM_BIT block bytes: a block of prose then
+// fills a little over half the bitmap, for about 3% of its size
+const size_t BYTES_PER_GRAM_BIT = 4;
+
+struct SearchBlock {
+    uint64_t fileOffset;
+    uint64_t rawOffset;
+    uint32_t rawSize;
+    long filter;   // Index into the filter list, or -1 if none covers the block
+};
+
+bool startsWith(const std::string& text, const char* prefix, size_t length) {
+    return text.length() >= length && text.compare(0, length, prefix, length) == 0;
+}
+
+bool endsWith(const std::string& text, const char* suffix, size_t length) {
+    return text.length() >= length && text.compare(text.length() - length, length, suffix, length) == 0;
+}
+
+} // namespace
+
+BlockFilter BlockFilter::build(const char* data, size_t length) {
+    BlockFilter filter;
+    std::memset(filter.bytes, 0, sizeof(filter.bytes));
+    size_t edge = length < EDGE_BYTES ? length : EDGE_BYTES;
+    filter.head.assign(data, edge);
+    filter.tail.assign(data + length - edge, edge);
+    while (filter.bitsLog2 < MAX_BITS_LOG2 && (size_t(1) << filter.bitsLog2) < length / BYTES_PER_GRAM_BIT) {
+        filter.bitsLog2++;
+    }
+    filter.grams.assign((size_t(1) << filter.bitsLog2) / 64, 0);
+
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(data);
+    uint32_t mask = (1u << filter.bitsLog2) - 1;
+    for (size_t i = 0; i < length; ++i) {
+        filter.bytes[text[i] / 64] |= uint64_t(1) << (text[i] % 64);
+        if (i + 1 < length) {
+            uint32_t bit = pairAt(text, i) & mask;
+            filter.grams[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+        if (i + 2 < length) {
+            uint32_t bit = tripleAt(text, i) & mask;
+            filter.grams[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+    return filter;
+}
+
+BlockFilter BlockFilter::read(std::istream& in) {
+    BlockFilter filter;
+    for (uint64_t& word : filter.bytes) word = readValue<uint64_t>(in);
+    for (std::string* edge : {&filter.head, &filter.tail}) {
+        uint8_t length = readValue<uint8_t>(in);
+        if (length > EDGE_BYTES) {
+            throw std::runtime_error("Corrupt block filter");
+        }
+        edge->assign(length, '\0');
+        if (length > 0 && !in.read(&(*edge)[0], length)) {
+            throw std::runtime_error("Unexpected end of compressed data");
+        }
+    }
+    filter.bitsLog2 = readValue<uint8_t>(in);
+    if (filter.bitsLog2 < MIN_BITS_LOG2 || filter.bitsLog2 > MAX_BITS_LOG2) {
+        throw std::runtime_error("Corrupt block filter");
+    }
+    filter.grams.resize((size_t(1) << filter.bitsLog2) / 64);
+    for (uint64_t& word : filter.grams) word = readValue<uint64_t>(in);
+    return filter;
+}
+
+void BlockFilter::write(std::ostream& out) const {
+    for (uint64_t word : bytes) writeValue<uint64_t>(out, word);
+    for (const std::string* edge : {&head, &tail}) {
+        writeValue<uint8_t>(out, static_cast<uint8_t>(edge->length()));
+        out << *edge;
+    }
+    writeValue<uint8_t>(out, static_cast<uint8_t>(bitsLog2));
+    for (uint64_t word : grams) writeValue<uint64_t>(out, word);
+}
+
+bool BlockFilter::mayHold(const char* data, size_t length) const {
+    const unsigned char* text = reinterpret_cast<const unsigned char*>(data);
+    uint32_t mask = (1u << bitsLog2) - 1;
+    for (size_t i = 0; i < length; ++i) {
+        if (!((bytes[text[i] / 64] >> (text[i] % 64)) & 1)) return false;
+    }
+    for (size_t i = 0; i + 1 < length; ++i) {
+        uint32_t bit = pairAt(text, i) & mask;
+        if (!((grams[bit / 64] >> (bit % 64)) & 1)) return false;
+        if (i + 2 < length) {
+            bit = tripleAt(text, i) & mask;
+            if (!((grams[bit / 64] >> (bit % 64)) & 1)) return false;
+        }
+    }
+    return true;
+}
+
+bool Search::mayContain(const BlockFilter* filter, const std::string& pattern) {
+    return !filter || filter->mayHold(pattern.data(), pattern.length());
+}
+
+// Could the pattern start in left and end in right? For a split at k,
+// pattern[0, k) must end left and pattern[k, m) must begin right. Parts up to
+// EDGE_BYTES long are compared with the stored edges; longer parts must also
+// pass the filter.
+bool Search::maySpan(const BlockFilter* left, const BlockFilter* right, const std::string& pattern) {
+    if (!left || !right) return true;
+    const size_t edge = BlockFilter::EDGE_BYTES;
+    const char* text = pattern.data();
+    size_t m = pattern.length();
+
+    for (size_t k = 1; k < m; ++k) {
+        bool leftFits = k <= edge ? endsWith(left->tail, text, k)
+                                  : left->tail.length() == edge && endsWith(left->tail, text + k - edge, edge)
+                                    && left->mayHold(text, k);
+        if (!leftFits) continue;
+        bool rightFits = m - k <= edge ? startsWith(right->head, text + k, m - k)
+                                       : right->head.length() == edge && startsWith(right->head, text + k, edge)
+                                         && right->mayHold(text + k, m - k);
+        if (rightFits) return true;
+    }
+    return false;
+}
+
+SearchResult Search::find(std::istream& in, const std::string& pattern, size_t maxOffsets) {
+    if (pattern.empty()) {
+        throw std::invalid_argument("Search pattern must not be empty");
+    }
+
+    char magic[sizeof(Compressor::MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !Compressor::isCompressed(std::string(magic, sizeof(magic)))) {
+        throw std::runtime_error("Not a compressed file (bad magic)");
+    }
+
+    // Headers and filters only; payloads are seeked over
+    std::vector<SearchBlock> blocks;
+    std::vector<BlockFilter> filters;
+    {
+        ScopedPhase phase("scan");
+        size_t covered = 0;
+        uint64_t pos = sizeof(Compressor::MAGIC), rawOffset = 0;
+        BlockHeader header;
+        while (Compressor::readBlockHeader(in, header)) {
+            if (header.mode == BLOCK_FILTER) {
+                uint32_t count = readValue<uint32_t>(in);
+                if (count > blocks.size() - covered) {
+                    throw std::runtime_error("Filter block covers more blocks than precede it");
+                }
+                for (size_t i = blocks.size() - count; i < blocks.size(); ++i) {
+                    blocks[i].filter = static_cast<long>(filters.size());
+                    filters.push_back(BlockFilter::read(in));
+                }
+                covered = blocks.size();
+            } else if (header.rawSize > 0) {
+                blocks.push_back({pos, rawOffset, header.rawSize, -1});
+                rawOffset += header.rawSize;
+            }
+
+            pos += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+            in.clear();
+            in.seekg(pos);
+        }
+    }
+
+    // A match lies inside one block, across two neighbours, or across a block
+    // too short to hold anything but part of a match; decode only those
+    size_t m = pattern.length();
+    auto filterOf = [&](size_t i) { return blocks[i].filter < 0 ? nullptr : &filters[blocks[i].filter]; };
+    std::vector<char> needed(blocks.size(), 0);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (mayContain(filterOf(i), pattern)) needed[i] = 1;
+        if (i + 1 < blocks.size() && m > 1 && maySpan(filterOf(i), filterOf(i + 1), pattern)) {
+            needed[i] = needed[i + 1] = 1;
+        }
+        if (m > 1 && blocks[i].rawSize <= m - 2) {
+            needed[i] = 1;
+            if (i > 0) needed[i - 1] = 1;
+            if (i + 1 < blocks.size()) needed[i + 1] = 1;
+        }
+    }
+
+    SearchResult result;
+    result.blocks = blocks.size();
+
+    DecodeContext context;
+    context.container = &in;
+    context.history = [&in](uint64_t from, uint64_t count) {
+        return Compressor::decompressRange(in, from, count);
+    };
+
+    // The last m - 1 bytes of the previous block, if it was decoded
+    std::string carry;
+    BlockHeader header;
+    std::string payload;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!needed[i]) {
+            carry.clear();
+            continue;
+        }
+
+        in.clear();
+        in.seekg(blocks[i].fileOffset);
+        if (!Compressor::readBlock(in, header, payload)) {
+            throw std::runtime_error("Truncated block list");
+        }
+        std::string window = carry + Compressor::decodeVerified(header, payload, i, context);
+        result.decodedBlocks++;
+
+        ScopedPhase phase("match");
+        uint64_t base = blocks[i].rawOffset - carry.length();
+        for (size_t at = window.find(pattern); at != std::string::npos; at = window.find(pattern, at + 1)) {
+            result.matches++;
+            if (result.offsets.size() < maxOffsets) result.offsets.push_back(base + at);
+        }
+        carry = window.substr(window.length() - std::min(window.length(), m - 1));
+    }
+
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+// What one block contains, for ruling it out without decoding it. Byte
+// presence is exact. Byte pairs and triples are hashed into a bitmap sized to
+// the block, so a set bit may be a false positive but a clear bit proves
+// absence. The first and last EDGE_BYTES bytes are kept verbatim to check
+// matches that straddle a block boundary. Written by --searchable in
+// BLOCK_FILTER blocks, each covering the data blocks just before it.
+struct BlockFilter {
+    static const size_t EDGE_BYTES = 32;
+    static const int MIN_BITS_LOG2 = 12;
+    static const int MAX_BITS_LOG2 = 20;
+
+    uint64_t bytes[256 / 64];
+    std::string head;
+    std::string tail;
+    int bitsLog2 = MIN_BITS_LOG2;
+    std::vector<uint64_t> grams;
+
+    static BlockFilter build(const char* data, size_t length);
+    static BlockFilter read(std::istream& in);
+    void write(std::ostream& out) const;
+
+    // False only if text cannot occur anywhere in the block
+    bool mayHold(const char* text, size_t length) const;
+};
+
+struct SearchResult {
+    uint64_t matches = 0;             // Every occurrence, overlapping ones included
+    std::vector<uint64_t> offsets;    // Uncompressed offsets of the first maxOffsets matches
+    size_t blocks = 0;
+    size_t decodedBlocks = 0;
+};
+
+class Search {
+public:
+    // Finds a literal pattern in a compressed file. Blocks whose filter rules
+    // the pattern out, alone and together with a neighbour, are never decoded;
+    // files without filters have every block decoded, one at a time.
+    static SearchResult find(std::istream& in, const std::string& pattern, size_t maxOffsets);
+
+private:
+    // A null filter means the block was written without one and may hold anything
+    static bool mayContain(const BlockFilter* filter, const std::string& pattern);
+    static bool maySpan(const BlockFilter* left, const BlockFilter* right, const std::string& pattern);
+};
+
+#endif // SEARCH_H
@@ -0,0 +1,178 @@
+#include "Stats.h"
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(ch) < 0x20) continue;
+        escaped += ch;
+    }
+    return escaped;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+} // namespace
+
+Stats& Stats::global() {
+    static Stats stats;
+    return stats;
+}
+
+Stats::Stats()
+    : enabled(false), startCpuMs(0.0), uncompressedBytes(0), compressedBytes(0),
+      maxSymbolCount(0), maxTreeHeight(0), weightedCodeLength(0.0), treeSymbols(0) {
+}
+
+void Stats::enable() {
+    enabled = true;
+    start = std::chrono::steady_clock::now();
+    startCpuMs = processCpuTimeMs();
+}
+
+void Stats::addPhase(const std::string& phase, double wallMs, double cpuMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    PhaseStats& entry = phases[phase];
+    entry.wallMs += wallMs;
+    entry.cpuMs += cpuMs;
+    entry.calls++;
+}
+
+void Stats::addBytes(uint64_t uncompressed, uint64_t compressed) {
+    if (!enabled) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    uncompressedBytes += uncompressed;
+    compressedBytes += compressed;
+}
+
+void Stats::increment(const std::string& counter, uint64_t amount) {
+    if (!enabled) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    counters[counter] += amount;
+}
+
+void Stats::recordTree(size_t symbolCount, int height, double averageCodeLength, uint64_t symbolsCoded) {
+    if (!enabled) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (symbolCount > maxSymbolCount) maxSymbolCount = symbolCount;
+    if (height > maxTreeHeight) maxTreeHeight = height;
+    weightedCodeLength += averageCodeLength * symbolsCoded;
+    treeSymbols += symbolsCoded;
+}
+
+std::string Stats::toJson(const std::string& command, int status) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    double wallMs = elapsedMs(start);
+    double cpuMs = processCpuTimeMs() - startCpuMs;
+    double throughput = wallMs > 0.0 ? (uncompressedBytes / 1e6) / (wallMs / 1000.0) : 0.0;
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\"command\":\"" << jsonEscape(command) << "\""
+         << ",\"status\":" << status
+         << ",\"wall_ms\":" << wallMs
+         << ",\"cpu_ms\":" << cpuMs
+         << ",\"uncompressed_bytes\":" << uncompressedBytes
+         << ",\"compressed_bytes\":" << compressedBytes
+         << ",\"throughput_mbps\":" << throughput
+         << ",\"peak_rss_kb\":" << peakRssKb()
+         << ",\"symbol_count\":" << maxSymbolCount
+         << ",\"tree_height\":" << maxTreeHeight
+         << ",\"avg_code_length\":" << (treeSymbols > 0 ? weightedCodeLength / treeSymbols : 0.0);
+
+    for (const auto& counter : counters) {
+        json << ",\"" << counter.first << "\":" << counter.second;
+    }
+
+    json << ",\"phases\":{";
+    bool first = true;
+    for (const auto& phase : phases) {
+        json << (first ? "" : ",") << "\"" << phase.first << "\":{"
+             << "\"wall_ms\":" << phase.second.wallMs
+             << ",\"cpu_ms\":" << phase.second.cpuMs
+             << ",\"calls\":" << phase.second.calls << "}";
+        first = false;
+    }
+    json << "}}";
+
+    return json.str();
+}
+
+double Stats::cpuTimeMs() {
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10000.0;   // 100ns units
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0.0;
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#else
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+double Stats::processCpuTimeMs() {
+#if defined(_WIN32)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10000.0;   // 100ns units
+#else
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+uint64_t Stats::peakRssKb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;   // Bytes on macOS
+#else
+    return usage.ru_maxrss;          // Kilobytes on Linux
+#endif
+#endif
+}
+
+ScopedPhase::ScopedPhase(const char* phase)
+    : phase(phase), active(Stats::global().isEnabled()), cpuStart(0.0)
+#ifdef HUFFMAN_TRACE
+    , trace(phase)
+#endif
+{
+    if (active) {
+        wallStart = std::chrono::steady_clock::now();
+        cpuStart = Stats::cpuTimeMs();
+    }
+}
+
+ScopedPhase::~ScopedPhase() {
+    if (active) {
+        Stats::global().addPhase(phase, elapsedMs(wallStart), Stats::cpuTimeMs() - cpuStart);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "Trace.h"
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// Opt-in performance statistics (enabled by --stats json). When disabled,
+// every hook is a single branch on a flag.
+struct PhaseStats {
+    double wallMs = 0.0;
+    double cpuMs = 0.0;
+    uint64_t calls = 0;
+};
+
+class Stats {
+public:
+    static Stats& global();
+
+    void enable();
+    bool isEnabled() const { return enabled; }
+
+    void addPhase(const std::string& phase, double wallMs, double cpuMs);
+    void addBytes(uint64_t uncompressed, uint64_t compressed);
+    void increment(const std::string& counter, uint64_t amount = 1);
+
+    // Tree shape, weighted by how many symbols each tree coded
+    void recordTree(size_t symbolCount, int height, double averageCodeLength, uint64_t symbolsCoded);
+
+    // One JSON object on a single line
+    std::string toJson(const std::string& command, int status) const;
+
+    // CPU time in milliseconds for the calling thread / the whole process
+    static double cpuTimeMs();
+    static double processCpuTimeMs();
+    static uint64_t peakRssKb();
+
+private:
+    Stats();
+
+    bool enabled;
+    std::chrono::steady_clock::time_point start;
+    double startCpuMs;
+
+    mutable std::mutex mutex;
+    std::map<std::string, PhaseStats> phases;
+    std::map<std::string, uint64_t> counters;
+    uint64_t uncompressedBytes;
+    uint64_t compressedBytes;
+
+    size_t maxSymbolCount;
+    int maxTreeHeight;
+    double weightedCodeLength;
+    uint64_t treeSymbols;
+};
+
+// Times the enclosing scope as one call of the named phase; in a
+// -DHUFFMAN_TRACE build it is also a trace scope of the same name
+class ScopedPhase {
+public:
+    explicit ScopedPhase(const char* phase);
+    ~ScopedPhase();
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    const char* phase;
+    bool active;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+#ifdef HUFFMAN_TRACE
+    TraceScope trace;
+#endif
+};
+
+#endif // STATS_H
@@ -0,0 +1,114 @@
+#include "ThreadPool.h"
+
+namespace {
+
+// Worker index of the calling thread, or -1 outside the pool
+thread_local int currentWorker = -1;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) : pending(0), queued(0), stopping(false), nextQueue(0) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Tasks spawned by a worker stay local; outside tasks are dealt round-robin
+    bool spawned = currentWorker >= 0;
+    size_t index = spawned ? static_cast<size_t>(currentWorker) : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pending++;
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back({std::move(task), spawned});
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()>& task) {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    std::deque<Task>& tasks = queues[index]->tasks;
+    if (tasks.empty()) return false;
+    if (tasks.back().spawned) {
+        task = std::move(tasks.back().run);
+        tasks.pop_back();
+    } else {
+        task = std::move(tasks.front().run);
+        tasks.pop_front();
+    }
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, std::function<void()>& task) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& victim = *queues[(thief + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front().run);
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentWorker = static_cast<int>(index);
+
+    while (true) {
+        std::function<void()> task;
+        if (popLocal(index, task) || steal(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queued--;
+            }
+
+            try {
+                task();
+            } catch (...) {
+                // Tasks report their own failures; never let one kill the worker
+            }
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pending == 0) allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
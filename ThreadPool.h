@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+// Work-stealing thread pool: each worker owns a deque and steals the oldest
+// task from a sibling when it runs dry, so one long task never holds up the
+// queue behind it. Tasks submitted from outside run in submission order;
+// tasks a worker spawns itself run newest-first while their data is hot.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0);   // 0 = hardware concurrency
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    size_t size() const;
+
+private:
+    struct Task {
+        std::function<void()> run;
+        bool spawned;   // Submitted by the worker that owns the queue
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t pending;          // Submitted but not yet finished
+    size_t queued;           // Sitting in a deque, not yet picked up
+    bool stopping;
+    std::atomic<size_t> nextQueue;
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, std::function<void()>& task);
+    bool steal(size_t thief, std::function<void()>& task);
+};
+
+#endif // THREADPOOL_H
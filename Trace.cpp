@@ -0,0 +1,140 @@
+#include "Trace.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <iomanip>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#if defined(HUFFMAN_TRACE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define HUFFMAN_PROBE(probe, name, arg) STAP_PROBE2(huffman, probe, name, arg)
+#endif
+#endif
+
+#ifndef HUFFMAN_PROBE
+#define HUFFMAN_PROBE(probe, name, arg) ((void)0)
+#endif
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* argName;   // nullptr if the scope has no argument
+    uint64_t arg;
+    uint64_t beginNs;
+    uint64_t endNs;
+};
+
+// Written only by its own thread; head counts every event ever recorded
+struct TraceRing {
+    explicit TraceRing(uint32_t threadId) : threadId(threadId), head(0), events(Trace::EVENTS_PER_THREAD) {}
+
+    uint32_t threadId;
+    std::atomic<uint64_t> head;
+    std::vector<TraceEvent> events;
+};
+
+// Rings outlive their threads so a dump still sees pool workers that have exited
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<TraceRing>> rings;
+uint64_t startNs = 0;
+
+thread_local TraceRing* threadRing = nullptr;
+
+TraceRing* registerThread() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.push_back(std::make_unique<TraceRing>(static_cast<uint32_t>(rings.size())));
+    return rings.back().get();
+}
+
+} // namespace
+
+std::atomic<bool> Trace::recording(false);
+
+bool Trace::compiledIn() {
+#ifdef HUFFMAN_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Trace::start() {
+    startNs = nowNs();
+    recording.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Trace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* name, uint64_t beginNs, uint64_t endNs, const char* argName, uint64_t arg) {
+    if (!threadRing) {
+        threadRing = registerThread();
+    }
+    uint64_t head = threadRing->head.load(std::memory_order_relaxed);
+    threadRing->events[head & (EVENTS_PER_THREAD - 1)] = {name, argName, arg, beginNs, endNs};
+    threadRing->head.store(head + 1, std::memory_order_release);
+}
+
+bool Trace::writeChromeJson(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    // Microseconds since start, as the format expects
+    auto micros = [](uint64_t ns) { return (ns - startNs) / 1000.0; };
+    long pid = static_cast<long>(getpid());
+    uint64_t dropped = 0;
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (const auto& ring : rings) {
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << ring->threadId << ",\"args\":{\"name\":\"thread " << ring->threadId << "\"}}";
+        first = false;
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t oldest = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        dropped += oldest;
+        for (uint64_t i = oldest; i < head; ++i) {
+            const TraceEvent& event = ring->events[i & (EVENTS_PER_THREAD - 1)];
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"ts\":" << micros(event.beginNs)
+                << ",\"dur\":" << (event.endNs - event.beginNs) / 1000.0
+                << ",\"pid\":" << pid << ",\"tid\":" << ring->threadId;
+            if (event.argName) {
+                out << ",\"args\":{\"" << event.argName << "\":" << event.arg << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+    return static_cast<bool>(out);
+}
+
+#ifdef HUFFMAN_TRACE
+
+TraceScope::TraceScope(const char* name, const char* argName, uint64_t arg)
+    : name(name), argName(argName), arg(arg), beginNs(Trace::isRecording() ? Trace::nowNs() : 0) {
+    HUFFMAN_PROBE(scope_begin, name, arg);
+}
+
+TraceScope::~TraceScope() {
+    HUFFMAN_PROBE(scope_end, name, arg);
+    if (beginNs != 0) {
+        Trace::record(name, beginNs, Trace::nowNs(), argName, arg);
+    }
+}
+
+#endif // HUFFMAN_TRACE
@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Scoped event tracing, compiled in only with -DHUFFMAN_TRACE. Without it
+// TRACE_SCOPE and TRACE_SCOPE_ARG expand to nothing and no scope costs
+// anything. With it, every ScopedPhase is also a trace scope.
+//
+// Each thread records finished scopes into its own fixed ring of events; only
+// that thread writes to it, so recording takes no lock and, once the ring is
+// full, overwrites its oldest events. Recording starts with Trace::start
+// (--trace=<file>), and writeChromeJson dumps the rings as Chrome trace JSON
+// for chrome://tracing or Perfetto. Where <sys/sdt.h> is available every scope
+// also fires the USDT probes huffman:scope_begin and huffman:scope_end (name,
+// argument), which are no-ops until perf or bpftrace attaches to them.
+class Trace {
+public:
+    static const size_t EVENTS_PER_THREAD = 1 << 14;   // Power of two
+
+    static bool compiledIn();
+
+    // Scopes that begin before this are not recorded
+    static void start();
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Call once the traced work is done; rings still being written to may
+    // lose or tear their newest events
+    static bool writeChromeJson(const std::string& path);
+
+    // Appends one finished scope to the calling thread's ring
+    static void record(const char* name, uint64_t beginNs, uint64_t endNs, const char* argName, uint64_t arg);
+
+    static uint64_t nowNs();
+
+private:
+    static std::atomic<bool> recording;
+};
+
+#ifdef HUFFMAN_TRACE
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* argName = nullptr, uint64_t arg = 0);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* argName;
+    uint64_t arg;
+    uint64_t beginNs;   // 0 when not recording
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, arg) \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, argName, static_cast<uint64_t>(arg))
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, argName, arg) ((void)0)
+
+#endif // HUFFMAN_TRACE
+
+#endif // TRACE_H
@@ -0,0 +1,232 @@
+#include "Updater.h"
+#include "BinaryIO.h"
+#include "Crc32c.h"
+#include "Search.h"
+#include "Stats.h"
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <unordered_map>
+#include <stdexcept>
+#include <filesystem>
+#include <cstdio>
+#include <cerrno>
+
+namespace {
+
+// Removes the temporary file unless it was renamed over the original
+class TempFileGuard {
+public:
+    explicit TempFileGuard(const std::string& path) : path(path), complete(false) {}
+    ~TempFileGuard() {
+        if (!complete) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+    }
+    TempFileGuard(const TempFileGuard&) = delete;
+    TempFileGuard& operator=(const TempFileGuard&) = delete;
+
+    void commit() { complete = true; }
+
+private:
+    std::string path;
+    bool complete;
+};
+
+// A new file next to path, named with a random suffix and created
+// exclusively, so concurrent updates never write into each other's file
+std::string createTempFile(const std::string& path) {
+    std::random_device random;
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        std::ostringstream name;
+        name << path << ".tmp." << std::hex << random() << random();
+        std::FILE* file = std::fopen(name.str().c_str(), "wbx");
+        if (file) {
+            std::fclose(file);
+            return name.str();
+        }
+        if (errno != EEXIST) break;
+    }
+    throw std::runtime_error("Cannot create a temporary file next to " + path);
+}
+
+} // namespace
+
+bool Updater::isSelfContained(BlockMode mode) {
+    switch (mode) {
+        case BLOCK_STORED:
+        case BLOCK_HUFFMAN:
+        case BLOCK_LZ77:
+        case BLOCK_BUILTIN:
+        case BLOCK_WORD:
+        case BLOCK_ANS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+UpdateResult Updater::update(const std::string& path, const std::string& text, const CompressOptions& options) {
+    std::ifstream old(path, std::ios::binary);
+    if (!old) {
+        throw std::runtime_error("Cannot open compressed file");
+    }
+
+    std::vector<BlockIndexEntry> oldIndex;
+    bool seekable = Compressor::readIndex(old, oldIndex);
+
+    // Headers and filters only, as in Search::find
+    std::vector<OldBlock> blocks;
+    std::vector<BlockFilter> filters;
+    bool searchable = false;
+    {
+        ScopedPhase phase("scan");
+        char magic[sizeof(Compressor::MAGIC)];
+        old.clear();
+        old.seekg(0);
+        if (!old.read(magic, sizeof(magic)) || !Compressor::isCompressed(std::string(magic, sizeof(magic)))) {
+            throw std::runtime_error("Not a compressed file (bad magic)");
+        }
+
+        size_t covered = 0;
+        uint64_t pos = sizeof(Compressor::MAGIC);
+        BlockHeader header;
+        while (Compressor::readBlockHeader(old, header)) {
+            if (header.mode == BLOCK_FILTER) {
+                searchable = true;
+                uint32_t count = readValue<uint32_t>(old);
+                if (count > blocks.size() - covered) {
+                    throw std::runtime_error("Filter block covers more blocks than precede it");
+                }
+                for (size_t i = blocks.size() - count; i < blocks.size(); ++i) {
+                    blocks[i].filter = static_cast<long>(filters.size());
+                    filters.push_back(BlockFilter::read(old));
+                }
+                covered = blocks.size();
+            } else if (header.rawSize > 0) {
+                blocks.push_back({pos, header, -1});
+            }
+
+            pos += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+            old.clear();
+            old.seekg(pos);
+        }
+    }
+
+    // Size and checksum, the same fingerprint ChunkIndex uses
+    std::unordered_map<uint64_t, std::vector<size_t>> candidates;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (isSelfContained(blocks[i].header.mode)) {
+            candidates[(static_cast<uint64_t>(blocks[i].header.rawSize) << 32) | blocks[i].header.checksum].push_back(i);
+        }
+    }
+
+    CompressOptions blockOptions = options;
+    blockOptions.contentDefined = true;
+    blockOptions.dedup = false;
+    blockOptions.seekable = options.seekable || seekable;
+    blockOptions.searchable = options.searchable || searchable;
+
+    // Declared before the stream, so the file is closed by the time it is removed
+    std::string tempPath = createTempFile(path);
+    TempFileGuard guard(tempPath);
+    // in | out opens the file just created without creating another
+    std::ofstream out(tempPath, std::ios::binary | std::ios::in | std::ios::out);
+    if (!out) {
+        throw std::runtime_error("Cannot create " + tempPath);
+    }
+    out.write(Compressor::MAGIC, sizeof(Compressor::MAGIC));
+
+    UpdateResult result;
+    std::vector<BlockIndexEntry> index;
+    std::vector<BlockFilter> newFilters;
+    uint64_t fileOffset = sizeof(Compressor::MAGIC);
+    size_t offset = 0;
+    std::string framed;
+    for (size_t end : Compressor::blockEnds(text, blockOptions)) {
+        const char* piece = text.data() + offset;
+        size_t length = end - offset;
+
+        // A matching checksum is only a hint; the decoded bytes decide
+        long reused = -1;
+        auto it = candidates.find((static_cast<uint64_t>(length) << 32) | crc32c(piece, length));
+        if (it != candidates.end()) {
+            ScopedPhase phase("match");
+            for (size_t i : it->second) {
+                const BlockHeader& header = blocks[i].header;
+                framed.assign(Compressor::BLOCK_HEADER_SIZE + header.payloadSize, '\0');
+                old.clear();
+                old.seekg(blocks[i].fileOffset);
+                if (!old.read(&framed[0], framed.size())) {
+                    throw std::runtime_error("Truncated block payload");
+                }
+                std::string payload = framed.substr(Compressor::BLOCK_HEADER_SIZE);
+                if (Compressor::decodeVerified(header, payload, i).compare(0, std::string::npos, piece, length) == 0) {
+                    reused = static_cast<long>(i);
+                    break;
+                }
+            }
+        }
+
+        std::vector<BlockHeader> headers;
+        if (reused >= 0) {
+            headers.push_back(blocks[reused].header);
+            if (blockOptions.searchable) {
+                long filter = blocks[reused].filter;
+                newFilters.push_back(filter >= 0 ? filters[filter] : BlockFilter::build(piece, length));
+            }
+            result.reusedBlocks++;
+        } else {
+            framed = Compressor::frameBlocks(text.substr(offset, length), blockOptions, headers);
+            if (blockOptions.searchable) {
+                size_t blockOffset = 0;
+                for (const BlockHeader& header : headers) {
+                    newFilters.push_back(BlockFilter::build(piece + blockOffset, header.rawSize));
+                    blockOffset += header.rawSize;
+                }
+            }
+            result.encodedBytes += length;
+        }
+
+        {
+            ScopedPhase phase("write");
+            out.write(framed.data(), framed.size());
+        }
+        uint64_t rawOffset = offset;
+        for (const BlockHeader& header : headers) {
+            index.push_back({rawOffset, fileOffset, header.rawSize});
+            rawOffset += header.rawSize;
+            fileOffset += Compressor::BLOCK_HEADER_SIZE + header.payloadSize;
+        }
+        offset = end;
+    }
+    old.close();
+
+    if (!newFilters.empty()) {
+        framed = Compressor::frameFilters(newFilters);
+        out.write(framed.data(), framed.size());
+        fileOffset += framed.size();
+    }
+    if (blockOptions.seekable) {
+        framed = Compressor::frameIndex(index);
+        out.write(framed.data(), framed.size());
+        fileOffset += framed.size();
+    }
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write " + tempPath);
+    }
+
+    // Only a complete file on disk replaces the old one, and the rename
+    // itself is flushed with the directory entry
+    syncToDisk(tempPath);
+    std::filesystem::rename(tempPath, path);
+    guard.commit();
+    syncParentDirectory(path);
+
+    result.rawBytes = text.length();
+    result.fileSize = fileOffset;
+    result.blocks = index.size();
+    return result;
+}
@@ -0,0 +1,43 @@
+#ifndef UPDATER_H
+#define UPDATER_H
+
+#include "Compressor.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+struct UpdateResult {
+    uint64_t rawBytes = 0;          // Uncompressed size of the new contents
+    uint64_t fileSize = 0;          // Size of the compressed file afterwards
+    size_t blocks = 0;
+    size_t reusedBlocks = 0;        // Copied from the old file without re-encoding
+    uint64_t encodedBytes = 0;      // Uncompressed bytes that went through the encoder
+};
+
+// Replaces the contents of a file written by compress with new text, and
+// re-encodes only what changed. The text is cut at the content-defined block
+// boundaries of --updatable, so an edit moves only the boundaries next to it.
+// A piece with the size and CRC32C of an old block, and the same bytes once
+// that block is decoded, keeps the old block's header and payload as they are.
+// Only blocks that decode on their own are reused; copy and reuse blocks name
+// file or raw offsets that the edit may have moved.
+//
+// The new file is written beside the old one and renamed over it once it is
+// on disk, so an interrupted update leaves the old contents. Seekable and
+// searchable files stay so, and the filters of reused blocks are kept.
+class Updater {
+public:
+    static UpdateResult update(const std::string& path, const std::string& text,
+                               const CompressOptions& options = CompressOptions());
+
+private:
+    struct OldBlock {
+        uint64_t fileOffset;
+        BlockHeader header;
+        long filter;   // Index into the old filters, or -1 if none covers the block
+    };
+
+    static bool isSelfContained(BlockMode mode);
+};
+
+#endif // UPDATER_H
@@ -0,0 +1,354 @@
+#include "WordCoder.h"
+#include "BinaryIO.h"
+#include "Stats.h"
+#include <unordered_map>
+#include <queue>
+#include <sstream>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+namespace {
+
+bool isWordByte(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch >= 0x80;
+}
+
+struct TableEntry {
+    uint32_t symbol;
+    uint8_t length;   // 0 if the code is longer than TABLE_BITS
+};
+
+} // namespace
+
+std::vector<std::string_view> WordCoder::tokenize(const std::string& text) {
+    std::vector<std::string_view> tokens;
+    size_t start = 0;
+    while (start < text.length()) {
+        bool word = isWordByte(static_cast<unsigned char>(text[start]));
+        size_t end = start + 1;
+        while (end < text.length() && end - start < MAX_TOKEN_LENGTH &&
+               isWordByte(static_cast<unsigned char>(text[end])) == word) {
+            ++end;
+        }
+        tokens.emplace_back(text.data() + start, end - start);
+        start = end;
+    }
+    return tokens;
+}
+
+// Huffman code lengths over an alphabet of arbitrary size. If the tree is
+// deeper than MAX_CODE_LENGTH the weights are flattened and it is rebuilt.
+void WordCoder::buildLengths(const std::vector<uint32_t>& frequencies, std::vector<uint8_t>& lengths) {
+    size_t n = frequencies.size();
+    lengths.assign(n, 0);
+    if (n == 0) return;
+    if (n == 1) {
+        lengths[0] = 1;
+        return;
+    }
+
+    std::vector<uint64_t> weights(frequencies.begin(), frequencies.end());
+    typedef std::pair<uint64_t, uint32_t> Entry;   // (weight, node); ties go to the lower node
+    for (;;) {
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        for (size_t i = 0; i < n; ++i) heap.push(Entry(weights[i], static_cast<uint32_t>(i)));
+
+        // Internal nodes are numbered after the leaves, each above both children
+        std::vector<uint32_t> parent(2 * n - 1);
+        uint32_t next = static_cast<uint32_t>(n);
+        while (heap.size() > 1) {
+            Entry a = heap.top();
+            heap.pop();
+            Entry b = heap.top();
+            heap.pop();
+            parent[a.second] = parent[b.second] = next;
+            heap.push(Entry(a.first + b.first, next++));
+        }
+
+        std::vector<uint8_t> depth(2 * n - 1, 0);
+        int maxDepth = 0;
+        for (size_t node = 2 * n - 2; node-- > 0;) {
+            depth[node] = static_cast<uint8_t>(std::min(depth[parent[node]] + 1, 255));
+            if (node < n) maxDepth = std::max<int>(maxDepth, depth[node]);
+        }
+
+        if (maxDepth <= MAX_CODE_LENGTH) {
+            std::copy(depth.begin(), depth.begin() + n, lengths.begin());
+            return;
+        }
+        for (uint64_t& weight : weights) weight = (weight + 1) / 2;
+    }
+}
+
+// Package-merge (coin collector): the optimal code lengths of at most
+// MAX_CODE_LENGTH bits. List 0 holds the leaves by weight; every further list
+// merges the leaves with adjacent pairs ("packages") of the list before. The
+// first 2n - 2 items of the last list make up the code, and each leaf gets one
+// bit for every list it is selected from.
+void WordCoder::packageMerge(const std::vector<uint32_t>& frequencies, std::vector<uint8_t>& lengths) {
+    size_t n = frequencies.size();
+    lengths.assign(n, 0);
+    if (n <= 1) {
+        if (n == 1) lengths[0] = 1;
+        return;
+    }
+
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return frequencies[a] < frequencies[b]; });
+
+    // isPackage[list][i]: whether item i of that list is a package or a leaf;
+    // leaves keep their order within every list
+    std::vector<std::vector<char>> isPackage(MAX_CODE_LENGTH);
+    std::vector<uint64_t> previous(n);
+    for (size_t i = 0; i < n; ++i) previous[i] = frequencies[order[i]];
+    isPackage[0].assign(n, 0);
+
+    for (int list = 1; list < MAX_CODE_LENGTH; ++list) {
+        std::vector<uint64_t> current;
+        current.reserve(n + previous.size() / 2);
+        size_t leaf = 0, pair = 0, pairs = previous.size() / 2;
+        while (leaf < n || pair < pairs) {
+            uint64_t packageWeight = pair < pairs ? previous[2 * pair] + previous[2 * pair + 1] : UINT64_MAX;
+            if (leaf < n && frequencies[order[leaf]] <= packageWeight) {
+                current.push_back(frequencies[order[leaf++]]);
+                isPackage[list].push_back(0);
+            } else {
+                current.push_back(packageWeight);
+                isPackage[list].push_back(1);
+                pair++;
+            }
+        }
+        previous.swap(current);
+    }
+
+    size_t selected = 2 * n - 2;
+    for (int list = MAX_CODE_LENGTH - 1; list >= 0; --list) {
+        size_t leaf = 0, packages = 0;
+        for (size_t i = 0; i < selected; ++i) {
+            if (isPackage[list][i]) packages++;
+            else lengths[order[leaf++]]++;
+        }
+        selected = 2 * packages;
+    }
+}
+
+// Canonical codes: shorter codes first, equal lengths in symbol order
+void WordCoder::assignCodes(const std::vector<uint8_t>& lengths, std::vector<uint32_t>& codes) {
+    uint32_t count[MAX_CODE_LENGTH + 1] = {0};
+    for (uint8_t length : lengths) count[length]++;
+    count[0] = 0;
+
+    uint32_t nextCode[MAX_CODE_LENGTH + 1] = {0};
+    uint32_t code = 0;
+    for (int length = 1; length <= MAX_CODE_LENGTH; ++length) {
+        code = (code + count[length - 1]) << 1;
+        nextCode[length] = code;
+    }
+
+    codes.assign(lengths.size(), 0);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        if (lengths[i] > 0) codes[i] = nextCode[lengths[i]]++;
+    }
+}
+
+std::string WordCoder::compress(const std::string& text, bool optimalLengths) {
+    std::vector<std::string_view> tokens;
+    std::vector<std::string_view> vocabulary;
+    std::vector<uint32_t> frequencies;
+    std::vector<uint32_t> stream;
+    {
+        ScopedPhase phase("tokenize");
+        tokens = tokenize(text);
+
+        // Hash-consing: every occurrence of a token maps to the id of its first one
+        std::unordered_map<std::string_view, uint32_t> ids;
+        ids.reserve(tokens.size() / 4 + 1);
+        stream.reserve(tokens.size());
+        for (std::string_view token : tokens) {
+            auto inserted = ids.emplace(token, static_cast<uint32_t>(vocabulary.size()));
+            if (inserted.second) {
+                vocabulary.push_back(token);
+                frequencies.push_back(0);
+            }
+            frequencies[inserted.first->second]++;
+            stream.push_back(inserted.first->second);
+        }
+    }
+
+    // Sorted, neighbouring tokens share long prefixes
+    std::vector<uint32_t> order(vocabulary.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return vocabulary[a] < vocabulary[b]; });
+    std::vector<uint32_t> rank(vocabulary.size());
+    std::vector<uint32_t> sortedFrequencies(vocabulary.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        rank[order[i]] = static_cast<uint32_t>(i);
+        sortedFrequencies[i] = frequencies[order[i]];
+    }
+
+    std::vector<uint8_t> lengths;
+    std::vector<uint32_t> codes;
+    {
+        ScopedPhase phase("tree_build");
+        if (optimalLengths) packageMerge(sortedFrequencies, lengths);
+        else buildLengths(sortedFrequencies, lengths);
+        assignCodes(lengths, codes);
+    }
+
+    std::ostringstream out(std::ios::binary);
+    writeValue<uint32_t>(out, static_cast<uint32_t>(vocabulary.size()));
+    std::string_view previous;
+    for (uint32_t id : order) {
+        std::string_view token = vocabulary[id];
+        size_t shared = 0;
+        while (shared < previous.length() && shared < token.length() && previous[shared] == token[shared]) ++shared;
+        writeValue<uint8_t>(out, static_cast<uint8_t>(shared));
+        writeValue<uint8_t>(out, static_cast<uint8_t>(token.length() - shared));
+        out.write(token.data() + shared, token.length() - shared);
+        previous = token;
+    }
+    out.write(reinterpret_cast<const char*>(lengths.data()), lengths.size());
+
+    ScopedPhase phase("encode");
+    uint64_t bitCount = 0;
+    for (size_t i = 0; i < lengths.size(); ++i) {
+        bitCount += static_cast<uint64_t>(sortedFrequencies[i]) * lengths[i];
+    }
+    writeValue<uint64_t>(out, bitCount);
+
+    // Codes go straight into packed bytes; only the low accumulated bits matter
+    std::string packed;
+    packed.reserve(bitCount / 8 + 1);
+    uint64_t accumulator = 0;
+    int pending = 0;
+    for (uint32_t id : stream) {
+        uint32_t symbol = rank[id];
+        accumulator = (accumulator << lengths[symbol]) | codes[symbol];
+        pending += lengths[symbol];
+        while (pending >= 8) {
+            pending -= 8;
+            packed.push_back(static_cast<char>(accumulator >> pending));
+        }
+    }
+    if (pending > 0) {
+        packed.push_back(static_cast<char>(accumulator << (8 - pending)));
+    }
+    out << packed;
+    return out.str();
+}
+
+std::string WordCoder::decompress(const std::string& payload) {
+    std::istringstream in(payload, std::ios::binary);
+    uint32_t symbolCount = readValue<uint32_t>(in);
+    if (static_cast<uint64_t>(symbolCount) * 3 > payload.length()) {
+        throw std::runtime_error("Corrupt word vocabulary");
+    }
+
+    // All tokens in one buffer; token i is [offsets[i], offsets[i + 1])
+    std::string pool;
+    std::vector<uint32_t> offsets(symbolCount + 1, 0);
+    size_t previousLength = 0;
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        uint8_t shared = readValue<uint8_t>(in);
+        uint8_t suffix = readValue<uint8_t>(in);
+        if (shared > previousLength) {
+            throw std::runtime_error("Corrupt word vocabulary");
+        }
+        size_t start = pool.length();
+        pool.append(pool, start - previousLength, shared);
+        pool.resize(start + shared + suffix);
+        if (suffix > 0 && !in.read(&pool[start + shared], suffix)) {
+            throw std::runtime_error("Unexpected end of compressed data");
+        }
+        previousLength = shared + suffix;
+        offsets[i + 1] = static_cast<uint32_t>(pool.length());
+    }
+
+    std::vector<uint8_t> lengths(symbolCount);
+    if (symbolCount > 0 && !in.read(reinterpret_cast<char*>(lengths.data()), symbolCount)) {
+        throw std::runtime_error("Unexpected end of compressed data");
+    }
+
+    // Counts per length and symbols in canonical order; reject over-full codes
+    uint32_t count[MAX_CODE_LENGTH + 1] = {0};
+    uint64_t kraft = 0;
+    for (uint8_t length : lengths) {
+        if (length == 0 || length > MAX_CODE_LENGTH) {
+            throw std::runtime_error("Invalid word code length");
+        }
+        count[length]++;
+        kraft += uint64_t(1) << (MAX_CODE_LENGTH - length);
+    }
+    if (kraft > (uint64_t(1) << MAX_CODE_LENGTH)) {
+        throw std::runtime_error("Invalid word code lengths");
+    }
+    std::vector<uint32_t> symbols(symbolCount);
+    {
+        uint32_t start[MAX_CODE_LENGTH + 2] = {0};
+        for (int length = 1; length <= MAX_CODE_LENGTH; ++length) start[length + 1] = start[length] + count[length];
+        for (uint32_t i = 0; i < symbolCount; ++i) symbols[start[lengths[i]]++] = i;
+    }
+
+    std::vector<uint32_t> codes;
+    assignCodes(lengths, codes);
+    std::vector<TableEntry> table(size_t(1) << TABLE_BITS, TableEntry{0, 0});
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        if (lengths[i] > TABLE_BITS) continue;
+        size_t first = static_cast<size_t>(codes[i]) << (TABLE_BITS - lengths[i]);
+        size_t span = size_t(1) << (TABLE_BITS - lengths[i]);
+        for (size_t j = 0; j < span; ++j) table[first + j] = TableEntry{i, lengths[i]};
+    }
+
+    uint64_t bitCount = readValue<uint64_t>(in);
+    std::string packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bitCount > static_cast<uint64_t>(packed.length()) * 8) {
+        throw std::runtime_error("Packed bit count exceeds payload size");
+    }
+
+    ScopedPhase phase("decode");
+    std::string text;
+    uint64_t window = 0;   // Low windowBits bits are unread input, zero padded past the end
+    int windowBits = 0;
+    size_t bytePos = 0;
+    uint64_t consumed = 0;
+    while (consumed < bitCount) {
+        while (windowBits <= 56) {
+            uint8_t byte = bytePos < packed.length() ? static_cast<uint8_t>(packed[bytePos]) : 0;
+            window = (window << 8) | byte;
+            ++bytePos;
+            windowBits += 8;
+        }
+
+        const TableEntry& entry = table[(window >> (windowBits - TABLE_BITS)) & ((1u << TABLE_BITS) - 1)];
+        uint32_t symbol = entry.symbol;
+        int length = entry.length;
+        if (length == 0) {
+            // Long code: canonical decode one bit at a time, as in BuiltinTable::decode
+            uint32_t value = 0, first = 0, index = 0;
+            for (length = 1; length <= MAX_CODE_LENGTH; ++length) {
+                value |= (window >> (windowBits - length)) & 1;
+                if (value - first < count[length]) {
+                    symbol = symbols[index + (value - first)];
+                    break;
+                }
+                index += count[length];
+                first = (first + count[length]) << 1;
+                value <<= 1;
+            }
+            if (length > MAX_CODE_LENGTH) {
+                throw std::runtime_error("Invalid code in encoded string");
+            }
+        }
+
+        windowBits -= length;
+        consumed += length;
+        if (consumed > bitCount) {
+            throw std::runtime_error("Incomplete encoded string");
+        }
+        text.append(pool, offsets[symbol], offsets[symbol + 1] - offsets[symbol]);
+    }
+    return text;
+}
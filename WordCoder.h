@@ -0,0 +1,38 @@
+#ifndef WORDCODER_H
+#define WORDCODER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Huffman coding over words and the separators between them instead of
+// single bytes. Word frequencies in prose are far more skewed than letter
+// frequencies, and each decoded symbol yields a whole token.
+//
+// Payload: uint32 vocabulary size, the vocabulary in byte order with each
+// token front-coded against the previous one (uint8 shared prefix, uint8
+// suffix length, suffix), one uint8 code length per token, uint64 bit count,
+// then the canonical codes packed MSB first (the packBits layout).
+class WordCoder {
+public:
+    static const size_t MAX_TOKEN_LENGTH = 255;
+    static const int MAX_CODE_LENGTH = 24;
+    static const int TABLE_BITS = 11;   // Codes up to this long decode with one table lookup
+
+    // Splits text into maximal runs of word bytes (ASCII letters, digits and
+    // all non-ASCII bytes) and of the other bytes, capped at MAX_TOKEN_LENGTH
+    static std::vector<std::string_view> tokenize(const std::string& text);
+
+    // optimalLengths selects package-merge, the best code within
+    // MAX_CODE_LENGTH; otherwise weights are flattened until the tree fits
+    static std::string compress(const std::string& text, bool optimalLengths = false);
+    static std::string decompress(const std::string& payload);
+
+private:
+    static void buildLengths(const std::vector<uint32_t>& frequencies, std::vector<uint8_t>& lengths);
+    static void packageMerge(const std::vector<uint32_t>& frequencies, std::vector<uint8_t>& lengths);
+    static void assignCodes(const std::vector<uint8_t>& lengths, std::vector<uint32_t>& codes);
+};
+
+#endif // WORDCODER_H
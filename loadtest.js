@@ -0,0 +1,486 @@
+// Load generator and request-log replayer for the web API.
+//
+//   node loadtest.js [--server=server_fixed.js | --url=http://host:port]
+//                    [--log=requests.jsonl] [--concurrency=8] [--requests=200]
+//                    [--sizes=1024,16384] [--mix=encode,file] [--repeat=1]
+//                    [--seed=1] [--save=workload.jsonl] [--json] [--keep]
+//
+// By default the server script is started on a free port in a scratch
+// directory holding links to ./huffman and public/, so every file the server
+// writes lands where it can be counted. It runs with HUFFMAN_METRICS_LOG set,
+// which makes server_fixed.js record one STATS line per CLI call.
+//
+// Request log: one JSON object per line.
+//   {"endpoint": "/api/encode", "body": {"text": "..."}}
+//   {"endpoint": "/api/decode"}
+//   {"endpoint": "/api/encode-file", "body": {"filename": "a.txt", "level": 6}, "size": 65536}
+//   {"endpoint": "/api/decode-file"}
+// A decode without a body decodes what the encode before it produced, and
+// runs after it on the same worker. encode-file writes its input first, from
+// "content" or "size" generated bytes, under a name unique to the run;
+// generated bytes depend only on --seed and the entry's line in the log.
+// "method" defaults to POST; lines without an endpoint are skipped.
+// Without --log a synthetic workload of --requests encode/decode pairs is
+// generated (--mix picks text and/or file pairs); --save writes it out as a
+// log so a later run can replay exactly the same requests.
+//
+// Reports p50/p95/p99/max latency per endpoint, requests per second, CLI
+// spawns and files created and deleted by the server during the run.
+
+const http = require("http");
+const net = require("net");
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { spawn } = require("child_process");
+
+const REPO = __dirname;
+const EXECUTABLE = process.platform === "win32" ? "huffman.exe" : "huffman";
+
+function parseArgs(argv) {
+  const options = {
+    server: "server_fixed.js",
+    url: null,
+    log: null,
+    concurrency: 8,
+    requests: 200,
+    sizes: [1024, 16384],
+    mix: ["encode", "file"],
+    repeat: 1,
+    seed: 1,
+    save: null,
+    json: false,
+    keep: false
+  };
+
+  for (const arg of argv) {
+    const [key, value] = arg.replace(/^--/, "").split(/=(.*)/s);
+    switch (key) {
+      case "server": options.server = value; break;
+      case "url": options.url = value.replace(/\/$/, ""); break;
+      case "log": options.log = value; break;
+      case "concurrency": options.concurrency = parseInt(value); break;
+      case "requests": options.requests = parseInt(value); break;
+      case "sizes": options.sizes = value.split(",").map((size) => parseInt(size)); break;
+      case "mix": options.mix = value.split(","); break;
+      case "repeat": options.repeat = parseInt(value); break;
+      case "seed": options.seed = parseInt(value); break;
+      case "save": options.save = value; break;
+      case "json": options.json = true; break;
+      case "keep": options.keep = true; break;
+      default: throw new Error(`Unknown option ${arg}`);
+    }
+  }
+  if (!(options.concurrency > 0) || !(options.requests > 0) || !(options.repeat > 0) ||
+      options.sizes.some((size) => !(size > 0))) {
+    throw new Error("--concurrency, --requests, --repeat and --sizes must be positive numbers");
+  }
+  return options;
+}
+
+// mulberry32: small, fast and the same on every platform
+function makeRng(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (state + 0x6d2b79f5) >>> 0;
+    let t = state;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+const WORDS = ("the of and to in is was that for on with as by at from this be are it which or an have " +
+  "request server file block table tree code value error time data stream index level record").split(" ");
+
+// Word-like text with a skewed word distribution, ending in a newline
+function makeText(rng, size) {
+  let text = "";
+  while (text.length < size) {
+    const word = WORDS[Math.floor(WORDS.length * rng() * rng())];
+    text += word + (rng() < 0.08 ? ".\n" : " ");
+  }
+  return text.slice(0, size - 1) + "\n";
+}
+
+function syntheticLog(options) {
+  const rng = makeRng(options.seed);
+  const entries = [];
+  for (let i = 0; i < options.requests; i++) {
+    const kind = options.mix[i % options.mix.length];
+    const size = options.sizes[Math.floor(rng() * options.sizes.length)];
+    if (kind === "encode") {
+      entries.push({ endpoint: "/api/encode", body: { text: makeText(rng, size) } });
+      entries.push({ endpoint: "/api/decode" });
+    } else if (kind === "file") {
+      entries.push({ endpoint: "/api/encode-file", body: { filename: `doc${i}.txt` }, size });
+      entries.push({ endpoint: "/api/decode-file" });
+    } else {
+      throw new Error(`Unknown --mix kind ${kind}`);
+    }
+  }
+  return entries;
+}
+
+function readLog(file) {
+  const entries = [];
+  let skipped = 0;
+  for (const line of fs.readFileSync(file, "utf8").split("\n")) {
+    if (!line.trim()) continue;
+    let entry;
+    try {
+      entry = JSON.parse(line);
+    } catch (err) {
+      skipped++;
+      continue;
+    }
+    if (entry && typeof entry.endpoint === "string") entries.push(entry);
+    else skipped++;
+  }
+  return { entries, skipped };
+}
+
+// A decode without a body belongs to the encode before it, so they form one job.
+// Each entry keeps its index in the log, which seeds any content generated for it.
+function groupJobs(entries) {
+  const jobs = [];
+  entries.forEach((entry, index) => {
+    const dependent = !entry.body && (entry.endpoint === "/api/decode" || entry.endpoint === "/api/decode-file");
+    if (dependent && jobs.length > 0) jobs[jobs.length - 1].push({ entry, index });
+    else jobs.push([{ entry, index }]);
+  });
+  return jobs;
+}
+
+function freePort() {
+  return new Promise((resolve, reject) => {
+    const server = net.createServer();
+    server.on("error", reject);
+    server.listen(0, "127.0.0.1", () => {
+      const port = server.address().port;
+      server.close(() => resolve(port));
+    });
+  });
+}
+
+function linkOrCopy(target, link) {
+  try {
+    fs.symlinkSync(target, link);
+  } catch (err) {
+    fs.cpSync(target, link, { recursive: true });
+  }
+}
+
+async function waitForHealth(url, child) {
+  const deadline = Date.now() + 10000;
+  while (Date.now() < deadline) {
+    if (child.exitCode !== null) throw new Error(`Server exited with code ${child.exitCode}`);
+    try {
+      const response = await send(null, url, { endpoint: "/api/health", method: "GET" });
+      if (response.status === 200) return;
+    } catch (err) {
+      // Not listening yet
+    }
+    await new Promise((resolve) => setTimeout(resolve, 50));
+  }
+  throw new Error("Server did not become healthy within 10 s");
+}
+
+async function startServer(options) {
+  const script = path.resolve(REPO, options.server);
+  if (!fs.existsSync(path.join(REPO, EXECUTABLE))) {
+    throw new Error(`${EXECUTABLE} not found in ${REPO}; build it first`);
+  }
+
+  const cwd = fs.mkdtempSync(path.join(os.tmpdir(), "huffman-load-"));
+  linkOrCopy(path.join(REPO, EXECUTABLE), path.join(cwd, EXECUTABLE));
+  linkOrCopy(path.join(REPO, "public"), path.join(cwd, "public"));
+  const metricsLog = path.join(cwd, "metrics.jsonl");
+  const port = await freePort();
+
+  const child = spawn(process.execPath, [script], {
+    cwd,
+    env: { ...process.env, PORT: String(port), HUFFMAN_METRICS_LOG: metricsLog },
+    stdio: ["ignore", "ignore", "inherit"]
+  });
+  const server = { child, cwd, url: `http://127.0.0.1:${port}`, metricsLog, ignored: new Set([EXECUTABLE, "public", "metrics.jsonl"]) };
+  try {
+    await waitForHealth(server.url, child);
+  } catch (err) {
+    await stopServer(server, false);
+    throw err;
+  }
+  return server;
+}
+
+async function stopServer(server, keep) {
+  if (server.child.exitCode === null) {
+    const exited = new Promise((resolve) => server.child.once("exit", resolve));
+    server.child.kill("SIGTERM");
+    await exited;
+  }
+  if (!keep) fs.rmSync(server.cwd, { recursive: true, force: true });
+}
+
+// Counts files that appear in or vanish from dir while the run is going on
+function watchFiles(dir, ignored) {
+  const counts = { created: 0, deleted: 0 };
+  let watcher = null;
+  try {
+    watcher = fs.watch(dir, (event, name) => {
+      if (event !== "rename" || !name || ignored.has(name)) return;
+      if (fs.existsSync(path.join(dir, name))) counts.created++;
+      else counts.deleted++;
+    });
+  } catch (err) {
+    counts.unavailable = err.message;
+  }
+  return { counts, close: () => watcher && watcher.close() };
+}
+
+// Forks since boot, from /proc/stat; null where that does not exist
+function forkCount() {
+  try {
+    const match = fs.readFileSync("/proc/stat", "utf8").match(/^processes (\d+)$/m);
+    return match ? parseInt(match[1]) : null;
+  } catch (err) {
+    return null;
+  }
+}
+
+function send(agent, url, entry) {
+  return new Promise((resolve, reject) => {
+    const method = entry.method || (entry.body ? "POST" : "GET");
+    const payload = entry.body ? Buffer.from(JSON.stringify(entry.body)) : null;
+    const started = process.hrtime.bigint();
+    const request = http.request(url + entry.endpoint, {
+      method,
+      agent: agent || undefined,
+      headers: payload ? { "Content-Type": "application/json", "Content-Length": payload.length } : {}
+    }, (response) => {
+      const chunks = [];
+      response.on("data", (chunk) => chunks.push(chunk));
+      response.on("end", () => {
+        const body = Buffer.concat(chunks);
+        let json = null;
+        try {
+          json = JSON.parse(body.toString("utf8"));
+        } catch (err) {
+          // Not JSON; the status code decides
+        }
+        resolve({
+          status: response.statusCode,
+          latencyMs: Number(process.hrtime.bigint() - started) / 1e6,
+          json,
+          bytesOut: payload ? payload.length : 0,
+          bytesIn: body.length
+        });
+      });
+    });
+    request.on("error", reject);
+    request.end(payload || undefined);
+  });
+}
+
+// Fills in what a job's later requests take from the responses before them
+function prepare(entry, index, previous, run, server) {
+  const prepared = { ...entry, body: entry.body ? { ...entry.body } : undefined };
+  if (entry.endpoint === "/api/decode" && !entry.body && previous && previous.json) {
+    prepared.body = { encoded: previous.json.encoded, sessionId: previous.json.sessionId };
+  } else if (entry.endpoint === "/api/decode-file" && !entry.body && previous && previous.json) {
+    prepared.body = { filename: previous.json.outputFile };
+  } else if (entry.endpoint === "/api/encode-file" && entry.body && entry.body.filename) {
+    // Inputs are written before the request, under a name unique to this run
+    prepared.body.filename = `load${run.id}-${run.files++}-${path.basename(entry.body.filename)}`;
+    if (server) {
+      // Seeded by position, not by run.files, so content does not depend on which worker got there first
+      const seed = (Math.imul(run.seed, 0x9e3779b1) + index) >>> 0;
+      const content = entry.content !== undefined ? entry.content : makeText(makeRng(seed), entry.size || 1024);
+      fs.writeFileSync(path.join(server.cwd, prepared.body.filename), content);
+      server.ignored.add(prepared.body.filename);
+    }
+  }
+  return prepared;
+}
+
+async function runJobs(jobs, options, url, server) {
+  const agent = new http.Agent({ keepAlive: true, maxSockets: options.concurrency });
+  const results = [];
+  const run = { id: process.pid, files: 0, seed: options.seed };
+  let next = 0;
+
+  async function worker() {
+    while (next < jobs.length) {
+      const job = jobs[next++];
+      let previous = null;
+      for (const { entry, index } of job) {
+        const prepared = prepare(entry, index, previous, run, server);
+        try {
+          previous = await send(agent, url, prepared);
+          const ok = previous.status >= 200 && previous.status < 300 && !(previous.json && previous.json.error);
+          results.push({ endpoint: entry.endpoint, ok, status: previous.status, ...previous });
+        } catch (err) {
+          results.push({ endpoint: entry.endpoint, ok: false, status: 0, latencyMs: 0, bytesOut: 0, bytesIn: 0 });
+          previous = null;
+        }
+      }
+    }
+  }
+
+  const started = process.hrtime.bigint();
+  await Promise.all(Array.from({ length: options.concurrency }, worker));
+  const wallMs = Number(process.hrtime.bigint() - started) / 1e6;
+  agent.destroy();
+  return { results, wallMs };
+}
+
+// Nearest rank
+function percentile(sorted, p) {
+  if (sorted.length === 0) return 0;
+  return sorted[Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1)];
+}
+
+function summarize(results, wallMs) {
+  const latencies = results.filter((result) => result.ok).map((result) => result.latencyMs).sort((a, b) => a - b);
+  return {
+    requests: results.length,
+    errors: results.filter((result) => !result.ok).length,
+    p50Ms: percentile(latencies, 50),
+    p95Ms: percentile(latencies, 95),
+    p99Ms: percentile(latencies, 99),
+    maxMs: latencies.length ? latencies[latencies.length - 1] : 0,
+    requestsPerSecond: wallMs > 0 ? (results.length * 1000) / wallMs : 0,
+    bytesOut: results.reduce((sum, result) => sum + result.bytesOut, 0),
+    bytesIn: results.reduce((sum, result) => sum + result.bytesIn, 0)
+  };
+}
+
+// One STATS record per CLI call, tagged with the endpoint that made it.
+// A line cut short by the server being stopped mid-write is skipped.
+function readSpawns(metricsLog) {
+  const spawns = { total: 0, cpuMs: 0, byEndpoint: {} };
+  if (!metricsLog || !fs.existsSync(metricsLog)) return null;
+  for (const line of fs.readFileSync(metricsLog, "utf8").split("\n")) {
+    if (!line.trim()) continue;
+    let stats;
+    try {
+      stats = JSON.parse(line);
+    } catch (err) {
+      continue;
+    }
+    spawns.total++;
+    spawns.cpuMs += stats.cpu_ms || 0;
+    spawns.byEndpoint[stats.endpoint] = (spawns.byEndpoint[stats.endpoint] || 0) + 1;
+  }
+  return spawns;
+}
+
+function printReport(report) {
+  const format = (value) => value.toFixed(1).padStart(9);
+  console.log(`Target: ${report.target}, concurrency ${report.concurrency}, ${report.jobs} jobs, ${report.wallMs.toFixed(0)} ms`);
+  console.log(`${"endpoint".padEnd(20)}${"requests".padStart(9)}${"errors".padStart(8)}` +
+              `${"p50 ms".padStart(9)}${"p95 ms".padStart(9)}${"p99 ms".padStart(9)}${"max ms".padStart(9)}${"req/s".padStart(9)}`);
+  for (const [endpoint, summary] of Object.entries(report.endpoints).concat([["all", report.overall]])) {
+    console.log(`${endpoint.padEnd(20)}${String(summary.requests).padStart(9)}${String(summary.errors).padStart(8)}` +
+                `${format(summary.p50Ms)}${format(summary.p95Ms)}${format(summary.p99Ms)}${format(summary.maxMs)}` +
+                `${format(summary.requestsPerSecond)}`);
+  }
+
+  if (report.spawns) {
+    const perEndpoint = Object.entries(report.spawns.byEndpoint).map(([endpoint, count]) => `${endpoint} ${count}`).join(", ");
+    console.log(`CLI spawns: ${report.spawns.total} (${(report.spawns.total / report.overall.requests).toFixed(2)} per request; ` +
+                `${perEndpoint}), CLI CPU ${report.spawns.cpuMs.toFixed(0)} ms`);
+  } else if (report.target.startsWith("server")) {
+    console.log("CLI spawns: not reported by this server (no HUFFMAN_METRICS_LOG support)");
+  }
+  if (report.forks !== null) {
+    console.log(`Processes forked system-wide: ${report.forks}`);
+  }
+  if (report.files) {
+    console.log(`Server files: ${report.files.created} created, ${report.files.deleted} deleted, ${report.files.left} left at the end`);
+  }
+  if (report.skippedLogLines) {
+    console.log(`Skipped ${report.skippedLogLines} log lines without an endpoint`);
+  }
+}
+
+// Runs the jobs against the server or URL and builds the report
+async function measure(jobs, options, server, skipped) {
+  const url = options.url || server.url;
+  const watched = server ? [watchFiles(server.cwd, server.ignored), watchFiles(os.tmpdir(), new Set([path.basename(server.cwd)]))] : [];
+  const forksBefore = forkCount();
+
+  let outcome;
+  try {
+    outcome = await runJobs(jobs, options, url, server);
+  } finally {
+    // Metrics lines are appended asynchronously after each response
+    await new Promise((resolve) => setTimeout(resolve, 200));
+    watched.forEach((watch) => watch.close());
+  }
+  const forksAfter = forkCount();
+
+  const report = {
+    target: server ? options.server : url,
+    concurrency: options.concurrency,
+    jobs: jobs.length,
+    wallMs: outcome.wallMs,
+    overall: summarize(outcome.results, outcome.wallMs),
+    endpoints: {},
+    spawns: server ? readSpawns(server.metricsLog) : null,
+    forks: forksBefore !== null && forksAfter !== null ? forksAfter - forksBefore : null,
+    files: null,
+    skippedLogLines: skipped
+  };
+  for (const endpoint of [...new Set(outcome.results.map((result) => result.endpoint))]) {
+    report.endpoints[endpoint] = summarize(outcome.results.filter((result) => result.endpoint === endpoint), outcome.wallMs);
+  }
+  if (server) {
+    const left = fs.readdirSync(server.cwd).filter((name) => !server.ignored.has(name));
+    report.files = {
+      created: watched.reduce((sum, watch) => sum + watch.counts.created, 0),
+      deleted: watched.reduce((sum, watch) => sum + watch.counts.deleted, 0),
+      left: left.length
+    };
+  }
+  return report;
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+
+  let entries;
+  let skipped = 0;
+  if (options.log) {
+    ({ entries, skipped } = readLog(options.log));
+    if (entries.length === 0) {
+      throw new Error(`${options.log} has no replayable requests (${skipped} lines skipped)`);
+    }
+  } else {
+    entries = syntheticLog(options);
+  }
+  if (options.save) {
+    fs.writeFileSync(options.save, entries.map((entry) => JSON.stringify(entry)).join("\n") + "\n");
+  }
+
+  let jobs = groupJobs(entries);
+  jobs = Array.from({ length: options.repeat }, () => jobs).flat();
+
+  const server = options.url ? null : await startServer(options);
+  let report;
+  try {
+    report = await measure(jobs, options, server, skipped);
+  } finally {
+    // Also on failure, so no server or scratch directory outlives the run
+    if (server) await stopServer(server, options.keep);
+  }
+
+  if (options.json) console.log(JSON.stringify(report));
+  else printReport(report);
+  return report.overall.errors > 0 ? 1 : 0;
+}
+
+main().then((code) => process.exit(code), (err) => {
+  console.error(`ERROR: ${err.message}`);
+  process.exit(1);
+});
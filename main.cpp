@@ -1,18 +1,144 @@
 #include "HuffmanTree.h"
+#include "Compressor.h"
+#include "BuiltinTables.h"
+#include "LZ77.h"
+#include "Crc32c.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Batch.h"
+#include "Archive.h"
+#include "Pipeline.h"
+#include "Appender.h"
+#include "Updater.h"
+#include "Search.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <iomanip>
+#include <vector>
+#include <sstream>
 
-void compressFile(const std::string& inputPath, const std::string& encodedPath, const std::string& treePath) {
-    std::ifstream inFile(inputPath);
-    if (!inFile) {
-        std::cerr << "Failed to open input file: " << inputPath << std::endl;
-        return;
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+bool readBinaryFile(const std::string& path, std::string& contents) {
+    ScopedPhase phase("read");
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    contents.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool writeBinaryFile(const std::string& path, const std::string& contents) {
+    ScopedPhase phase("write");
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.write(contents.data(), contents.size());
+    return static_cast<bool>(file);
+}
+
+// "-" in place of a path or text argument means stdin/stdout
+const std::string STDIO_PATH = "-";
+
+// Stops the C runtime translating "\n" on Windows, which would corrupt
+// binary input and the byte counts of framed output
+void setBinaryStdio() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+std::string readStdin() {
+    ScopedPhase phase("read");
+    setBinaryStdio();
+    return std::string((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+}
+
+// Binary-safe output record: "<KEY>_BYTES:<n>", a newline, exactly n raw
+// bytes, then a newline. Readers take n bytes instead of scanning for a line end.
+void writeFramed(const std::string& key, const std::string& data) {
+    ScopedPhase phase("write");
+    setBinaryStdio();
+    std::cout << key << "_BYTES:" << data.length() << '\n';
+    std::cout.write(data.data(), data.length());
+    std::cout << std::endl;
+}
+
+// Tree argument naming a compile-time table instead of a tree file
+const std::string BUILTIN_PREFIX = "builtin:";
+
+// Decimal digits only: std::stoull alone would accept "-5" and wrap it
+bool parseCount(const std::string& text, uint64_t& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+    try {
+        value = std::stoull(text);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+// "-1" .. "-9"
+bool isLevelFlag(const std::string& arg) {
+    return arg.length() == 2 && arg[0] == '-' && arg[1] >= '0' + Compressor::MIN_LEVEL && arg[1] <= '0' + Compressor::MAX_LEVEL;
+}
+
+// Parses compress flags: a level, "--lz", "--lz=<level>", "--seekable", "--dedup" and the other
+// per-block switches; returns false on an unknown or malformed flag
+bool parseCompressOptions(const std::vector<std::string>& args, CompressOptions& options) {
+    // The level sets the baseline; the other flags override it whatever their order
+    for (const std::string& arg : args) {
+        if (isLevelFlag(arg)) {
+            Compressor::applyLevel(options, arg[1] - '0');
+        }
+    }
+
+    for (const std::string& arg : args) {
+        if (isLevelFlag(arg)) {
+            continue;
+        } else if (arg == "--lz") {
+            options.lzLevel = LZ77::DEFAULT_LEVEL;
+        } else if (arg.rfind("--lz=", 0) == 0) {
+            try {
+                options.lzLevel = std::stoi(arg.substr(5));
+            } catch (...) {
+                return false;
+            }
+            if (options.lzLevel < LZ77::MIN_LEVEL || options.lzLevel > LZ77::MAX_LEVEL) return false;
+        } else if (arg == "--dedup") {
+            options.dedup = true;
+        } else if (arg == "--words") {
+            options.words = true;
+        } else if (arg == "--searchable") {
+            options.searchable = true;
+        } else if (arg == "--updatable") {
+            options.contentDefined = true;
+        } else if (arg == "--seekable") {
+            // Smaller blocks so a range read decodes little beyond what was asked for
+            options.seekable = true;
+            options.blockSize = Compressor::SEEKABLE_BLOCK_SIZE;
+        } else {
+            return false;
+        }
     }
+    return true;
+}
 
-    std::string text((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-    inFile.close();
+bool compressFile(const std::string& inputPath, const std::string& encodedPath, const std::string& treePath, uint32_t& checksum) {
+    std::string text;
+    {
+        ScopedPhase phase("read");
+        std::ifstream inFile(inputPath);
+        if (!inFile) {
+            std::cerr << "Failed to open input file: " << inputPath << std::endl;
+            return false;
+        }
+        text.assign((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    }
+    checksum = crc32c(text);
 
     std::cout << "=== File Compression ===" << std::endl;
     std::cout << "Input file: " << inputPath << std::endl;
@@ -26,7 +152,7 @@ void compressFile(const std::string& inputPath, const std::string& encodedPath,
     std::ofstream encodedFile(encodedPath, std::ios::binary);
     if (!encodedFile) {
         std::cerr << "Failed to open encoded output file: " << encodedPath << std::endl;
-        return;
+        return false;
     }
     encodedFile << encoded;
     encodedFile.close();
@@ -35,54 +161,117 @@ void compressFile(const std::string& inputPath, const std::string& encodedPath,
         std::cout << "Huffman tree saved to: " << treePath << std::endl;
     } else {
         std::cerr << "Failed to save Huffman tree." << std::endl;
-        return;
+        return false;
     }
 
     std::cout << "Encoded size: " << encoded.length() << " bits" << std::endl;
     double ratio = static_cast<double>(encoded.length()) / (text.length() * 8) * 100.0;
     std::cout << "Compression ratio: " << std::fixed << std::setprecision(2) << ratio << "%" << std::endl;
+    return true;
 }
 
-void decompressFile(const std::string& encodedPath, const std::string& treePath, const std::string& outputPath) {
-    std::ifstream encodedFile(encodedPath, std::ios::binary);
-    if (!encodedFile) {
-        std::cerr << "Failed to open encoded file: " << encodedPath << std::endl;
-        return;
+bool decompressFile(const std::string& encodedPath, const std::string& treePath, const std::string& outputPath, uint32_t& checksum) {
+    std::string encoded;
+    {
+        ScopedPhase phase("read");
+        std::ifstream encodedFile(encodedPath, std::ios::binary);
+        if (!encodedFile) {
+            std::cerr << "Failed to open encoded file: " << encodedPath << std::endl;
+            return false;
+        }
+        encoded.assign((std::istreambuf_iterator<char>(encodedFile)), std::istreambuf_iterator<char>());
     }
 
-    std::string encoded((std::istreambuf_iterator<char>(encodedFile)), std::istreambuf_iterator<char>());
-    encodedFile.close();
-
     HuffmanTree huffman;
     if (!huffman.loadTreeFromFile(treePath)) {
         std::cerr << "Failed to load Huffman tree from: " << treePath << std::endl;
-        return;
+        return false;
     }
 
     std::string decoded = huffman.decode(encoded);
+    checksum = crc32c(decoded);
 
     std::ofstream outFile(outputPath);
     if (!outFile) {
         std::cerr << "Failed to open output file: " << outputPath << std::endl;
-        return;
+        return false;
     }
     outFile << decoded;
     outFile.close();
 
     std::cout << "Decoded text written to: " << outputPath << std::endl;
     std::cout << "Decoded size: " << decoded.length() * 8 << " bits" << std::endl;
+    return true;
+}
+
+void recordTreeStats(const HuffmanTree& huffman, size_t symbolsCoded) {
+    if (Stats::global().isEnabled()) {
+        Stats::global().recordTree(huffman.getFrequencies().size(), huffman.getTreeHeight(),
+                                   huffman.getAverageCodeLength(), symbolsCoded);
+    }
+}
+
+// Removes "--stats json" / "--stats=json" from argv; returns true if it was present
+bool stripStatsFlag(int& argc, char* argv[]) {
+    bool found = false;
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats=json") {
+            found = true;
+        } else if (arg == "--stats" && i + 1 < argc && std::string(argv[i + 1]) == "json") {
+            found = true;
+            ++i;
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+    argv[argc] = nullptr;
+    return found;
+}
+
+// Removes "--trace=<file>" from argv and returns the file, or "" if absent
+std::string stripTraceFlag(int& argc, char* argv[]) {
+    const std::string prefix = "--trace=";
+    std::string path;
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind(prefix, 0) == 0) {
+            path = arg.substr(prefix.length());
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+    argv[argc] = nullptr;
+    return path;
 }
 
 void printUsage() {
     std::cout << "Usage:\n";
-    std::cout << "  huffman encode <input_text> - Encode text directly\n";
-    std::cout << "  huffman decode <encoded_text> <tree_file> - Decode text using tree file\n";
+    std::cout << "  huffman encode <input_text|-> - Encode text directly (\"-\" reads stdin and prints the tree or TABLE:<name>)\n";
+    std::cout << "  huffman decode <encoded_text|-> <tree_file|-|builtin:name> - Decode text using tree file (\"-\" reads stdin, tree first)\n";
     std::cout << "  huffman encode_file <input_file> <output_file> - Encode file\n";
-    std::cout << "  huffman decode_file <input_file> <output_file> - Decode file\n";
+    std::cout << "  huffman decode_file <input_file> <output_file> - Decode file (legacy or compressed)\n";
+    std::cout << "  huffman compress <input_file> <output_file> [-1..-9] [--lz[=1-9]] [--seekable] [--dedup] [--words] [--searchable] [--updatable] - Compress file to a self-contained archive\n";
+    std::cout << "  huffman decompress <input_file> <output_file> - Decompress an archive made by compress\n";
+    std::cout << "  huffman append <compressed_file> <input_file|-> [--lz[=1-9]] - Add data to a compressed file without recompressing it\n";
+    std::cout << "  huffman update <compressed_file> <input_file|-> [-1..-9] [--lz[=1-9]] - Replace the contents, re-encoding only changed blocks\n";
+    std::cout << "  huffman decode_range <input_file> <offset> <length> <output_file|-> - Decode only a byte range\n";
+    std::cout << "  huffman search <input_file> <pattern|-> [--max=N] - Find a literal pattern, decoding only blocks that may hold it\n";
+    std::cout << "  huffman archive_create <archive> <file>... [--no-shared] [compress flags] - Bundle files into one archive\n";
+    std::cout << "  huffman archive_list <archive> - List archive members\n";
+    std::cout << "  huffman archive_extract <archive> <member> <output_file> - Extract one member\n";
+    std::cout << "  huffman batch <compress|decompress> <dir|list_file|-> <output_dir> [--threads=N] [compress flags] - Process many files\n";
     std::cout << "  huffman (no args) - Run original compression demo\n";
+    std::cout << "Binary output sent to stdout is framed as KEY_BYTES:<n>, a newline, then n raw bytes\n";
+    std::cout << "Any command also accepts --stats json to print a STATS:{...} line with timings\n";
+    std::cout << "and, in a build with -DHUFFMAN_TRACE, --trace=<file> to write a Chrome trace of its phases and blocks\n";
 }
 
-int main(int argc, char* argv[]) {
+int runCommand(int argc, char* argv[]) {
     // If no arguments, run the original demo
     if (argc == 1) {
         const std::string inputFile = "input.txt";
@@ -90,14 +279,12 @@ int main(int argc, char* argv[]) {
         const std::string treeFile = "huffman_tree.dat";
         const std::string outputFile = "output.txt";
 
-        compressFile(inputFile, encodedFile, treeFile);
-        decompressFile(encodedFile, treeFile, outputFile);
-
-        // Validate the result
-        std::ifstream in1(inputFile), in2(outputFile);
-        std::string orig((std::istreambuf_iterator<char>(in1)), std::istreambuf_iterator<char>());
-        std::string dec((std::istreambuf_iterator<char>(in2)), std::istreambuf_iterator<char>());
-        std::cout << "Verification: " << (orig == dec ? "SUCCESS" : "FAIL") << std::endl;
+        // Validate the result by checksum instead of re-reading both files
+        uint32_t originalChecksum = 0, decodedChecksum = 0;
+        bool ok = compressFile(inputFile, encodedFile, treeFile, originalChecksum)
+               && decompressFile(encodedFile, treeFile, outputFile, decodedChecksum)
+               && originalChecksum == decodedChecksum;
+        std::cout << "Verification: " << (ok ? "SUCCESS" : "FAIL") << std::endl;
 
         return 0;
     }
@@ -107,58 +294,128 @@ int main(int argc, char* argv[]) {
 
     try {
         if (command == "encode" && argc == 3) {
-            std::string text = argv[2];
+            bool streaming = argv[2] == STDIO_PATH;
+            std::string text = streaming ? readStdin() : argv[2];
+
+            // Streaming callers take the tree from our output, so they can also be
+            // handed a built-in table when it beats building and storing a tree
+            if (streaming) {
+                std::unordered_map<char, int> freqMap = Compressor::histogram(text);
+                uint64_t builtinBits;
+                const BuiltinTable& table = BuiltinTable::best(freqMap, builtinBits);
+                uint64_t treeBits = HuffmanTree::estimateEncodedBits(freqMap)
+                                  + 8 * HuffmanTree::serializedTreeSize(freqMap.size());
+                if (builtinBits <= treeBits) {
+                    std::string encoded = table.encode(text);
+                    Stats::global().addBytes(text.length(), (encoded.length() + 7) / 8);
+
+                    std::cout << "ENCODED:" << encoded << std::endl;
+                    std::cout << "ORIGINAL_SIZE:" << text.length() << std::endl;
+                    std::cout << "ENCODED_SIZE:" << encoded.length() << std::endl;
+                    std::cout << "TABLE:" << table.name() << std::endl;
+                    return 0;
+                }
+            }
             
             HuffmanTree huffman;
             huffman.buildTree(text);
             
             std::string encoded = huffman.encode(text);
+            recordTreeStats(huffman, text.length());
+            Stats::global().addBytes(text.length(), (encoded.length() + 7) / 8);
             
             // Output in format expected by web server
             std::cout << "ENCODED:" << encoded << std::endl;
             std::cout << "ORIGINAL_SIZE:" << text.length() << std::endl;
             std::cout << "ENCODED_SIZE:" << encoded.length() << std::endl;
+
+            // Hand the tree back to a streaming caller so it can pipe it into decode
+            if (streaming) {
+                std::ostringstream tree(std::ios::binary);
+                huffman.saveTree(tree);
+                writeFramed("TREE", tree.str());
+            }
             
         } else if (command == "decode" && argc == 4) {
-            std::string encoded = argv[2];
             std::string treeFile = argv[3];
-            
+            bool streaming = argv[2] == STDIO_PATH || treeFile == STDIO_PATH;
+
+            if (treeFile.rfind(BUILTIN_PREFIX, 0) == 0) {
+                const BuiltinTable* table = BuiltinTable::find(treeFile.substr(BUILTIN_PREFIX.length()));
+                if (!table) {
+                    std::cout << "ERROR:Unknown built-in table" << std::endl;
+                    return 1;
+                }
+
+                std::string encoded = argv[2] == STDIO_PATH ? readStdin() : argv[2];
+                std::string decoded = table->decode(encoded);
+                Stats::global().addBytes(decoded.length(), (encoded.length() + 7) / 8);
+                writeFramed("DECODED", decoded);
+                return 0;
+            }
+
+            // With "-" for both, stdin holds the tree followed by the bits
             HuffmanTree huffman;
-            if (!huffman.loadTreeFromFile(treeFile)) {
+            bool loaded;
+            if (treeFile == STDIO_PATH) {
+                setBinaryStdio();
+                loaded = huffman.loadTree(std::cin);
+            } else {
+                loaded = huffman.loadTreeFromFile(treeFile);
+            }
+            if (!loaded) {
                 std::cout << "ERROR:Cannot load tree file" << std::endl;
                 return 1;
             }
+
+            std::string encoded = argv[2] == STDIO_PATH ? readStdin() : argv[2];
             
             std::string decoded = huffman.decode(encoded);
-            std::cout << "DECODED:" << decoded << std::endl;
+            recordTreeStats(huffman, decoded.length());
+            Stats::global().addBytes(decoded.length(), (encoded.length() + 7) / 8);
+            if (streaming) {
+                writeFramed("DECODED", decoded);
+            } else {
+                std::cout << "DECODED:" << decoded << std::endl;
+            }
             
         } else if (command == "encode_file" && argc == 4) {
             std::string inputFile = argv[2];
             std::string outputFile = argv[3];
             
-            // Check if input file exists
-            std::ifstream inFile(inputFile);
-            if (!inFile) {
-                std::cout << "ERROR:Cannot open input file" << std::endl;
-                return 1;
+            std::string text;
+            {
+                ScopedPhase phase("read");
+
+                // Check if input file exists
+                std::ifstream inFile(inputFile);
+                if (!inFile) {
+                    std::cout << "ERROR:Cannot open input file" << std::endl;
+                    return 1;
+                }
+                
+                text.assign((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+                inFile.close();
             }
             
-            std::string text((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
-            inFile.close();
-            
             HuffmanTree huffman;
             huffman.buildTree(text);
             
             std::string encoded = huffman.encode(text);
+            recordTreeStats(huffman, text.length());
+            Stats::global().addBytes(text.length(), encoded.length());
             
             // Save encoded data
-            std::ofstream encodedFile(outputFile, std::ios::binary);
-            if (!encodedFile) {
-                std::cout << "ERROR:Cannot create output file" << std::endl;
-                return 1;
+            {
+                ScopedPhase phase("write");
+                std::ofstream encodedFile(outputFile, std::ios::binary);
+                if (!encodedFile) {
+                    std::cout << "ERROR:Cannot create output file" << std::endl;
+                    return 1;
+                }
+                encodedFile << encoded;
+                encodedFile.close();
             }
-            encodedFile << encoded;
-            encodedFile.close();
             
             // Save tree file (same name as output but with .tree extension)
             std::string treeFile = outputFile + ".tree";
@@ -174,14 +431,23 @@ int main(int argc, char* argv[]) {
             std::string outputFile = argv[3];
             
             // Check if input file exists
-            std::ifstream encodedFile(inputFile, std::ios::binary);
-            if (!encodedFile) {
+            std::string encoded;
+            if (!readBinaryFile(inputFile, encoded)) {
                 std::cout << "ERROR:Cannot open encoded file" << std::endl;
                 return 1;
             }
-            
-            std::string encoded((std::istreambuf_iterator<char>(encodedFile)), std::istreambuf_iterator<char>());
-            encodedFile.close();
+
+            // Files written by compress carry their own tables
+            if (Compressor::isCompressed(encoded)) {
+                std::string decoded = Compressor::decompress(encoded);
+                Stats::global().addBytes(decoded.length(), encoded.length());
+                if (!writeBinaryFile(outputFile, decoded)) {
+                    std::cout << "ERROR:Cannot create output file" << std::endl;
+                    return 1;
+                }
+                std::cout << "SUCCESS:File decoded successfully" << std::endl;
+                return 0;
+            }
             
             // Look for tree file (same name as input but with .tree extension)
             std::string treeFile = inputFile + ".tree";
@@ -193,18 +459,292 @@ int main(int argc, char* argv[]) {
             }
             
             std::string decoded = huffman.decode(encoded);
+            recordTreeStats(huffman, decoded.length());
+            Stats::global().addBytes(decoded.length(), encoded.length());
             
             // Save decoded data
-            std::ofstream outFile(outputFile);
-            if (!outFile) {
-                std::cout << "ERROR:Cannot create output file" << std::endl;
-                return 1;
+            {
+                ScopedPhase phase("write");
+                std::ofstream outFile(outputFile);
+                if (!outFile) {
+                    std::cout << "ERROR:Cannot create output file" << std::endl;
+                    return 1;
+                }
+                outFile << decoded;
+                outFile.close();
             }
-            outFile << decoded;
-            outFile.close();
             
             std::cout << "SUCCESS:File decoded successfully" << std::endl;
             
+        } else if (command == "compress" && argc >= 4) {
+            std::string inputFile = argv[2];
+            std::string outputFile = argv[3];
+
+            CompressOptions options;
+            if (!parseCompressOptions(std::vector<std::string>(argv + 4, argv + argc), options)) {
+                printUsage();
+                return 1;
+            }
+
+            uint64_t originalSize, compressedSize;
+            if (Pipeline::isSupported() && !options.dedup && !options.contentDefined) {
+                // Overlaps disk reads and writes with block coding
+                PipelineResult result = Pipeline::compressFile(inputFile, outputFile, options);
+                originalSize = result.inputBytes;
+                compressedSize = result.outputBytes;
+            } else {
+                std::string text;
+                if (!readBinaryFile(inputFile, text)) {
+                    std::cout << "ERROR:Cannot open input file" << std::endl;
+                    return 1;
+                }
+
+                std::string compressed = Compressor::compress(text, options);
+                if (!writeBinaryFile(outputFile, compressed)) {
+                    std::cout << "ERROR:Cannot create output file" << std::endl;
+                    return 1;
+                }
+                originalSize = text.length();
+                compressedSize = compressed.length();
+            }
+            Stats::global().addBytes(originalSize, compressedSize);
+
+            std::cout << "SUCCESS:File compressed successfully" << std::endl;
+            std::cout << "ORIGINAL_SIZE:" << originalSize << std::endl;
+            std::cout << "COMPRESSED_SIZE:" << compressedSize << std::endl;
+
+        } else if (command == "decompress" && argc == 4) {
+            std::string inputFile = argv[2];
+            std::string outputFile = argv[3];
+
+            if (Pipeline::isSupported()) {
+                PipelineResult result = Pipeline::decompressFile(inputFile, outputFile);
+                Stats::global().addBytes(result.outputBytes, result.inputBytes);
+            } else {
+                std::string compressed;
+                if (!readBinaryFile(inputFile, compressed)) {
+                    std::cout << "ERROR:Cannot open encoded file" << std::endl;
+                    return 1;
+                }
+
+                std::string decoded = Compressor::decompress(compressed);
+                Stats::global().addBytes(decoded.length(), compressed.length());
+                if (!writeBinaryFile(outputFile, decoded)) {
+                    std::cout << "ERROR:Cannot create output file" << std::endl;
+                    return 1;
+                }
+            }
+
+            std::cout << "SUCCESS:File decompressed successfully" << std::endl;
+
+        } else if (command == "append" && argc >= 4) {
+            std::string compressedFile = argv[2];
+            std::string inputFile = argv[3];
+
+            // Block size and seekability follow the existing file
+            CompressOptions options;
+            if (!parseCompressOptions(std::vector<std::string>(argv + 4, argv + argc), options)) {
+                printUsage();
+                return 1;
+            }
+
+            std::string text;
+            if (inputFile == STDIO_PATH) {
+                text = readStdin();
+            } else if (!readBinaryFile(inputFile, text)) {
+                std::cout << "ERROR:Cannot open input file" << std::endl;
+                return 1;
+            }
+
+            AppendResult result = Appender::append(compressedFile, text, options);
+            Stats::global().addBytes(result.appendedBytes, result.fileSize);
+
+            std::cout << "SUCCESS:Data appended successfully" << std::endl;
+            std::cout << "APPENDED_SIZE:" << result.appendedBytes << std::endl;
+            std::cout << "COMPRESSED_SIZE:" << result.fileSize << std::endl;
+
+        } else if (command == "update" && argc >= 4) {
+            std::string compressedFile = argv[2];
+            std::string inputFile = argv[3];
+
+            // Seekability and filters follow the existing file
+            CompressOptions options;
+            if (!parseCompressOptions(std::vector<std::string>(argv + 4, argv + argc), options)) {
+                printUsage();
+                return 1;
+            }
+
+            std::string text;
+            if (inputFile == STDIO_PATH) {
+                text = readStdin();
+            } else if (!readBinaryFile(inputFile, text)) {
+                std::cout << "ERROR:Cannot open input file" << std::endl;
+                return 1;
+            }
+
+            UpdateResult result = Updater::update(compressedFile, text, options);
+            Stats::global().addBytes(result.rawBytes, result.fileSize);
+
+            std::cout << "SUCCESS:File updated successfully" << std::endl;
+            std::cout << "BLOCKS_TOTAL:" << result.blocks << std::endl;
+            std::cout << "BLOCKS_REUSED:" << result.reusedBlocks << std::endl;
+            std::cout << "ENCODED_SIZE:" << result.encodedBytes << std::endl;
+            std::cout << "COMPRESSED_SIZE:" << result.fileSize << std::endl;
+
+        } else if (command == "decode_range" && argc == 6) {
+            std::string inputFile = argv[2];
+            uint64_t offset, length;
+            if (!parseCount(argv[3], offset) || !parseCount(argv[4], length)) {
+                std::cout << "ERROR:Offset and length must be non-negative integers" << std::endl;
+                return 1;
+            }
+            std::string outputFile = argv[5];
+
+            // Only the index and the covering blocks are read from disk
+            std::ifstream compressed(inputFile, std::ios::binary);
+            if (!compressed) {
+                std::cout << "ERROR:Cannot open encoded file" << std::endl;
+                return 1;
+            }
+
+            std::string decoded = Compressor::decompressRange(compressed, offset, length);
+            Stats::global().addBytes(decoded.length(), 0);
+            if (outputFile == STDIO_PATH) {
+                writeFramed("DECODED", decoded);
+            } else if (!writeBinaryFile(outputFile, decoded)) {
+                std::cout << "ERROR:Cannot create output file" << std::endl;
+                return 1;
+            }
+
+            std::cout << "SUCCESS:Range decoded successfully" << std::endl;
+            std::cout << "DECODED_SIZE:" << decoded.length() << std::endl;
+
+        } else if (command == "search" && (argc == 4 || argc == 5)) {
+            std::string inputFile = argv[2];
+            std::string pattern = argv[3] == STDIO_PATH ? readStdin() : argv[3];
+
+            size_t maxOffsets = 100;
+            if (argc == 5) {
+                std::string arg = argv[4];
+                if (arg.rfind("--max=", 0) != 0) {
+                    printUsage();
+                    return 1;
+                }
+                maxOffsets = std::stoul(arg.substr(6));
+            }
+
+            std::ifstream compressed(inputFile, std::ios::binary);
+            if (!compressed) {
+                std::cout << "ERROR:Cannot open encoded file" << std::endl;
+                return 1;
+            }
+
+            SearchResult result = Search::find(compressed, pattern, maxOffsets);
+
+            std::cout << "SUCCESS:Search completed" << std::endl;
+            std::cout << "MATCHES:" << result.matches << std::endl;
+            std::cout << "BLOCKS_TOTAL:" << result.blocks << std::endl;
+            std::cout << "BLOCKS_DECODED:" << result.decodedBlocks << std::endl;
+            for (uint64_t offset : result.offsets) {
+                std::cout << "MATCH:" << offset << std::endl;
+            }
+
+        } else if (command == "archive_create" && argc >= 4) {
+            std::string archiveFile = argv[2];
+
+            std::vector<std::string> files, flags;
+            bool useSharedTable = true;
+            for (int i = 3; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--no-shared") useSharedTable = false;
+                else if (arg.rfind("--", 0) == 0) flags.push_back(arg);
+                else files.push_back(arg);
+            }
+
+            CompressOptions options;
+            if (files.empty() || !parseCompressOptions(flags, options)) {
+                printUsage();
+                return 1;
+            }
+
+            std::string error;
+            if (!Archive::create(archiveFile, files, options, useSharedTable, error)) {
+                std::cout << "ERROR:" << error << std::endl;
+                return 1;
+            }
+            std::cout << "SUCCESS:Archive created with " << files.size() << " members" << std::endl;
+
+        } else if (command == "archive_list" && argc == 3) {
+            std::ifstream archive(argv[2], std::ios::binary);
+            if (!archive) {
+                std::cout << "ERROR:Cannot open archive" << std::endl;
+                return 1;
+            }
+
+            for (const auto& entry : Archive::list(archive)) {
+                std::cout << "MEMBER:" << entry.name << ":" << entry.rawSize << ":" << entry.storedSize << std::endl;
+            }
+
+        } else if (command == "archive_extract" && argc == 5) {
+            std::ifstream archive(argv[2], std::ios::binary);
+            if (!archive) {
+                std::cout << "ERROR:Cannot open archive" << std::endl;
+                return 1;
+            }
+
+            std::string contents = Archive::extract(archive, argv[3]);
+            Stats::global().addBytes(contents.length(), 0);
+            if (!writeBinaryFile(argv[4], contents)) {
+                std::cout << "ERROR:Cannot create output file" << std::endl;
+                return 1;
+            }
+            std::cout << "SUCCESS:Member extracted successfully" << std::endl;
+
+        } else if (command == "batch" && argc >= 5) {
+            std::string mode = argv[2];
+            std::string source = argv[3];
+            std::string outputDir = argv[4];
+            if (mode != "compress" && mode != "decompress") {
+                printUsage();
+                return 1;
+            }
+            BatchMode batchMode = mode == "compress" ? BATCH_COMPRESS : BATCH_DECOMPRESS;
+
+            size_t threads = 0;
+            std::vector<std::string> flags;
+            for (int i = 5; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg.rfind("--threads=", 0) == 0) {
+                    threads = std::stoul(arg.substr(10));
+                } else {
+                    flags.push_back(arg);
+                }
+            }
+
+            CompressOptions options;
+            if (!parseCompressOptions(flags, options)) {
+                printUsage();
+                return 1;
+            }
+
+            std::vector<BatchJob> jobs;
+            std::string error;
+            if (!Batch::collectJobs(batchMode, source, outputDir, jobs, error)) {
+                std::cout << "ERROR:" << error << std::endl;
+                return 1;
+            }
+
+            BatchSummary summary = Batch::run(batchMode, jobs, options, threads, std::cout);
+            double mbps = summary.seconds > 0.0 ? (summary.uncompressedBytes / 1e6) / summary.seconds : 0.0;
+
+            std::cout << "BATCH_FILES:" << summary.files << std::endl;
+            std::cout << "BATCH_FAILED:" << summary.failed << std::endl;
+            std::cout << "BATCH_INPUT_BYTES:" << summary.inputBytes << std::endl;
+            std::cout << "BATCH_OUTPUT_BYTES:" << summary.outputBytes << std::endl;
+            std::cout << "BATCH_SECONDS:" << std::fixed << std::setprecision(3) << summary.seconds << std::endl;
+            std::cout << "BATCH_MBPS:" << std::fixed << std::setprecision(2) << mbps << std::endl;
+            if (summary.failed > 0) return 1;
+
         } else {
             printUsage();
             return 1;
@@ -215,4 +755,34 @@ int main(int argc, char* argv[]) {
     }
 
     return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool statsRequested = stripStatsFlag(argc, argv);
+    if (statsRequested) {
+        Stats::global().enable();
+    }
+
+    std::string tracePath = stripTraceFlag(argc, argv);
+    if (!tracePath.empty()) {
+        if (!Trace::compiledIn()) {
+            std::cout << "ERROR:--trace needs a build with -DHUFFMAN_TRACE" << std::endl;
+            return 1;
+        }
+        Trace::start();
+    }
+
+    int status = runCommand(argc, argv);
+
+    if (!tracePath.empty() && !Trace::writeChromeJson(tracePath)) {
+        std::cout << "ERROR:Cannot write trace file " << tracePath << std::endl;
+        status = 1;
+    }
+
+    // One machine-readable line, after the command's own output
+    if (statsRequested) {
+        std::string command = argc > 1 ? argv[1] : "demo";
+        std::cout << "STATS:" << Stats::global().toJson(command, status) << std::endl;
+    }
+    return status;
 }
\ No newline at end of file
@@ -5,7 +5,7 @@ const fs = require("fs");
 const os = require("os");
 
 const app = express();
-const PORT = 3000;
+const PORT = process.env.PORT || 3000;
 
 // Middleware
 app.use(express.json());
@@ -1,11 +1,11 @@
 const express = require("express");
-const { exec } = require("child_process");
+const { execFile } = require("child_process");
 const path = require("path");
 const fs = require("fs");
 const os = require("os");
 
 const app = express();
-const PORT = 3000;
+const PORT = process.env.PORT || 3000;
 
 // Middleware
 app.use(express.json());
@@ -19,26 +19,83 @@ function getExecutablePath() {
   return process.platform === "win32" ? ".\\huffman.exe" : "./huffman";
 }
 
-// Helper function to escape text for Windows command line
-function escapeForWindows(text) {
-  return text.replace(/"/g, '""');
+// Optional metrics sink: when HUFFMAN_METRICS_LOG is set, every CLI call runs
+// with --stats json and its STATS line is appended there as one JSON record
+const METRICS_LOG = process.env.HUFFMAN_METRICS_LOG;
+
+function statsArgs() {
+  return METRICS_LOG ? ["--stats", "json"] : [];
 }
 
-// Helper function to create temp file with content
-function createTempFile(content, filename) {
-  return new Promise((resolve, reject) => {
-    fs.writeFile(filename, content, 'utf8', (err) => {
-      if (err) reject(err);
-      else resolve();
-    });
-  });
+// Optional tracing: when HUFFMAN_TRACE_DIR is set (and the CLI was built with
+// -DHUFFMAN_TRACE), every CLI call writes a Chrome trace of its phases and
+// blocks there, named after the endpoint and the time of the request
+const TRACE_DIR = process.env.HUFFMAN_TRACE_DIR;
+let traceCount = 0;
+
+function traceArgs(endpoint) {
+  if (!TRACE_DIR) return [];
+  const name = `${endpoint.replace(/^\/api\//, "")}-${Date.now()}-${traceCount++}.json`;
+  return [`--trace=${path.join(TRACE_DIR, name)}`];
 }
 
-// Helper function to delete file
-function deleteFile(filename) {
-  return new Promise((resolve) => {
-    fs.unlink(filename, () => resolve()); // Ignore errors
-  });
+// Helper function to forward the CLI's STATS line to the metrics log
+function forwardStats(endpoint, output) {
+  if (!METRICS_LOG || !output.fields.STATS) return;
+
+  try {
+    const stats = JSON.parse(output.fields.STATS);
+    stats.endpoint = endpoint;
+    stats.timestamp = new Date().toISOString();
+    fs.appendFile(METRICS_LOG, JSON.stringify(stats) + "\n", () => {});
+  } catch (err) {
+    console.error("Invalid stats line:", err.message);
+  }
+}
+
+// Helper function to parse CLI output: KEY:value lines go to fields, and
+// binary-safe KEY_BYTES:<n> records (n raw bytes after the newline) to records
+function parseOutput(stdout) {
+  const output = { fields: {}, records: {} };
+  let pos = 0;
+
+  while (pos < stdout.length) {
+    let end = stdout.indexOf(0x0a, pos);
+    if (end === -1) end = stdout.length;
+    const line = stdout.toString("utf8", pos, end).replace(/\r$/, "");
+    pos = end + 1;
+
+    const colon = line.indexOf(":");
+    if (colon === -1) continue;
+    const key = line.substring(0, colon);
+    const value = line.substring(colon + 1);
+
+    if (key.endsWith("_BYTES")) {
+      const length = parseInt(value);
+      output.records[key.slice(0, -6)] = stdout.subarray(pos, pos + length);
+      pos += length + 1;
+    } else {
+      output.fields[key] = value;
+    }
+  }
+  return output;
+}
+
+// Helper function to run the CLI without a shell. `input` (string or Buffer)
+// is piped to stdin, so request bodies never touch the disk or the command line.
+function runHuffman(endpoint, args, input, callback) {
+  const child = execFile(
+    getExecutablePath(),
+    args.concat(statsArgs(), traceArgs(endpoint)),
+    { encoding: "buffer", maxBuffer: 256 * 1024 * 1024 },
+    (error, stdout) => {
+      const output = parseOutput(stdout || Buffer.alloc(0));
+      forwardStats(endpoint, output);
+      callback(error, output);
+    }
+  );
+  child.stdin.on("error", () => {}); // The CLI may exit before reading everything
+  child.stdin.end(input === undefined ? "" : input);
 }
 
 // Encode text endpoint
@@ -49,32 +106,20 @@ app.post("/api/encode", async (req, res) => {
     return res.status(400).json({ error: "Text is required" });
   }
 
-  const execPath = getExecutablePath();
-  const escapedText = escapeForWindows(text);
-  
-  // Execute C++ program
-  exec(`${execPath} encode "${escapedText}"`, (error, stdout, stderr) => {
-    if (error) {
+  runHuffman("/api/encode", ["encode", "-"], text, (error, output) => {
+    if (error || !(output.records.TREE || output.fields.TABLE)) {
       console.error("Encoding error:", error);
       return res.status(500).json({ 
         error: "Encoding failed", 
-        details: error.message 
+        details: error ? error.message : output.fields.ERROR
       });
     }
 
-    // Parse the output from C++ program
-    const lines = stdout.trim().split(/\r?\n/);
-    const result = {};
-
-    lines.forEach((line) => {
-      if (line.startsWith("ENCODED:")) {
-        result.encoded = line.substring(8);
-      } else if (line.startsWith("ORIGINAL_SIZE:")) {
-        result.originalSize = parseInt(line.substring(14));
-      } else if (line.startsWith("ENCODED_SIZE:")) {
-        result.encodedSize = parseInt(line.substring(13));
-      }
-    });
+    const result = {
+      encoded: output.fields.ENCODED,
+      originalSize: parseInt(output.fields.ORIGINAL_SIZE),
+      encodedSize: parseInt(output.fields.ENCODED_SIZE)
+    };
 
     // Calculate compression ratio
     if (result.originalSize && result.encodedSize) {
@@ -83,9 +128,10 @@ app.post("/api/encode", async (req, res) => {
       ).toFixed(1);
     }
 
-    // Store the original text for decoding
+    // Keep the serialized tree, or the name of the built-in table used, for decoding
     const sessionId = Date.now().toString();
-    tempStorage.set(sessionId, text);
+    tempStorage.set(sessionId, { tree: output.records.TREE, table: output.fields.TABLE });
+    result.table = output.fields.TABLE;
     result.sessionId = sessionId;
 
     res.json(result);
@@ -106,101 +152,61 @@ app.post("/api/decode", async (req, res) => {
     });
   }
 
-  const originalText = tempStorage.get(sessionId);
-  const tempInputFile = `temp_input_${sessionId}.txt`;
-  const tempEncodedFile = `temp_encoded_${sessionId}.dat`;
-  const execPath = getExecutablePath();
-
-  try {
-    // Create temporary input file
-    await createTempFile(originalText, tempInputFile);
-
-    // First, create the tree by encoding the original text
-    exec(
-      `${execPath} encode_file "${tempInputFile}" "${tempEncodedFile}"`,
-      (error, stdout, stderr) => {
-        if (error) {
-          console.error("Tree creation error:", error);
-          return res.status(500).json({
-            error: "Failed to create tree file",
-            details: error.message
-          });
-        }
+  // stdin carries the tree (unless a built-in table was used) followed by the bits
+  const session = tempStorage.get(sessionId);
+  const bits = Buffer.from(encoded, "latin1");
+  const args = session.table ? ["decode", "-", `builtin:${session.table}`] : ["decode", "-", "-"];
+  const input = session.table ? bits : Buffer.concat([session.tree, bits]);
+
+  runHuffman("/api/decode", args, input, (error, output) => {
+    if (error || !output.records.DECODED) {
+      console.error("Decoding error:", error || output.fields.ERROR);
+      return res.status(500).json({
+        error: "Decoding failed",
+        details: error ? error.message : output.fields.ERROR
+      });
+    }
 
-        // Now decode using the tree file
-        const escapedEncoded = escapeForWindows(encoded);
-        exec(
-          `${execPath} decode "${escapedEncoded}" "${tempEncodedFile}.tree"`,
-          (decodeError, decodeStdout, decodeStderr) => {
-            if (decodeError) {
-              console.error("Decoding error:", decodeError);
-              return res.status(500).json({
-                error: "Decoding failed",
-                details: decodeError.message
-              });
-            }
-
-            const lines = decodeStdout.trim().split(/\r?\n/);
-            let decoded = "";
-
-            lines.forEach((line) => {
-              if (line.startsWith("DECODED:")) {
-                decoded = line.substring(8);
-              }
-            });
-
-            // Clean up temp files
-            Promise.all([
-              deleteFile(tempInputFile),
-              deleteFile(tempEncodedFile),
-              deleteFile(`${tempEncodedFile}.tree`)
-            ]).then(() => {
-              tempStorage.delete(sessionId);
-              res.json({ decoded });
-            });
-          }
-        );
-      }
-    );
-  } catch (err) {
-    console.error("File creation error:", err);
-    res.status(500).json({ error: "Failed to create temporary file" });
-  }
+    tempStorage.delete(sessionId);
+    res.json({ decoded: output.records.DECODED.toString("utf8") });
+  });
 });
 
 // Encode file endpoint
 app.post("/api/encode-file", (req, res) => {
-  const { filename } = req.body;
+  const { filename, level } = req.body;
 
   if (!filename) {
     return res.status(400).json({ error: "Filename is required" });
   }
+  if (level !== undefined && !(Number.isInteger(level) && level >= 1 && level <= 9)) {
+    return res.status(400).json({ error: "Level must be an integer from 1 to 9" });
+  }
 
+  // A level writes the block container, which decode-file reads as well
   const outputFile = `encoded_${filename}`;
-  const execPath = getExecutablePath();
-
-  exec(
-    `${execPath} encode_file "${filename}" "${outputFile}"`,
-    (error, stdout, stderr) => {
-      if (error) {
-        console.error("File encoding error:", error);
-        return res.status(500).json({ 
-          error: "File encoding failed", 
-          details: error.message 
-        });
-      }
+  const args = level === undefined
+    ? ["encode_file", filename, outputFile]
+    : ["compress", filename, outputFile, `-${level}`];
+  runHuffman("/api/encode-file", args, undefined, (error, output) => {
+    if (error) {
+      console.error("File encoding error:", error);
+      return res.status(500).json({ 
+        error: "File encoding failed", 
+        details: error.message 
+      });
+    }
 
-      if (stdout.includes("SUCCESS:")) {
-        res.json({
-          success: true,
-          message: `File encoded successfully as ${outputFile}`,
-          outputFile: outputFile
-        });
-      } else {
-        res.status(500).json({ error: "Encoding failed", details: stdout });
-      }
+    if (output.fields.SUCCESS !== undefined) {
+      res.json({
+        success: true,
+        message: `File encoded successfully as ${outputFile}`,
+        outputFile: outputFile
+      });
+    } else {
+      res.status(500).json({ error: "Encoding failed", details: output.fields.ERROR });
     }
-  );
+  });
 });
 
 // Decode file endpoint
@@ -212,43 +218,80 @@ app.post("/api/decode-file", (req, res) => {
   }
 
   const outputFile = `decoded_${filename}`;
-  const execPath = getExecutablePath();
-
-  exec(
-    `${execPath} decode_file "${filename}" "${outputFile}"`,
-    (error, stdout, stderr) => {
-      if (error) {
-        console.error("File decoding error:", error);
-        return res.status(500).json({ 
-          error: "File decoding failed", 
-          details: error.message 
-        });
-      }
+  runHuffman("/api/decode-file", ["decode_file", filename, outputFile], undefined, (error, output) => {
+    if (error) {
+      console.error("File decoding error:", error);
+      return res.status(500).json({ 
+        error: "File decoding failed", 
+        details: error.message 
+      });
+    }
 
-      if (stdout.includes("SUCCESS:")) {
-        res.json({
-          success: true,
-          message: `File decoded successfully as ${outputFile}`,
-          outputFile: outputFile
-        });
-      } else {
-        res.status(500).json({ error: "Decoding failed", details: stdout });
-      }
+    if (output.fields.SUCCESS !== undefined) {
+      res.json({
+        success: true,
+        message: `File decoded successfully as ${outputFile}`,
+        outputFile: outputFile
+      });
+    } else {
+      res.status(500).json({ error: "Decoding failed", details: output.fields.ERROR });
     }
-  );
+  });
 });
 
 // View file endpoint
+// Compressed files are previewed by decoding only the requested range
+// (?offset=&length=, default the first 4 KB) instead of the whole file
 app.get("/api/view-file/:filename", (req, res) => {
   const filename = req.params.filename;
 
-  fs.readFile(filename, "utf8", (err, data) => {
+  // Absent means the default; anything else must be a plain decimal count
+  const count = (value, fallback) =>
+    value === undefined ? fallback : /^\d+$/.test(value) ? Number(value) : NaN;
+  const offset = count(req.query.offset, 0);
+  const length = count(req.query.length, 4096);
+  if (!Number.isSafeInteger(offset) || !Number.isSafeInteger(length)) {
+    return res.status(400).json({ error: "Offset and length must be non-negative integers" });
+  }
+
+  // Only the 4-byte magic is needed to tell a compressed file from a plain one
+  fs.open(filename, "r", (err, fd) => {
     if (err) {
       console.error("File read error:", err);
       return res.status(404).json({ error: "File not found" });
     }
 
-    res.json({ content: data });
+    const magic = Buffer.alloc(4);
+    fs.read(fd, magic, 0, 4, 0, (err, bytesRead) => {
+      if (err || bytesRead < 4 || magic.toString("latin1") !== "HFZ1") {
+        return fs.readFile(fd, (readErr, data) => {
+          fs.close(fd, () => {});
+          if (readErr) {
+            console.error("File read error:", readErr);
+            return res.status(500).json({ error: "Failed to read file" });
+          }
+          res.json({ content: data.toString("utf8") });
+        });
+      }
+      fs.close(fd, () => {});
+
+      runHuffman(
+        "/api/view-file",
+        ["decode_range", filename, String(offset), String(length), "-"],
+        undefined,
+        (error, output) => {
+          if (error || !output.records.DECODED) {
+            console.error("Range decoding error:", error || output.fields.ERROR);
+            return res.status(500).json({ error: "Failed to decode file preview" });
+          }
+
+          // length is in decoded bytes, so offset + length is the next range
+          const decoded = output.records.DECODED;
+          const content = decoded.toString("utf8");
+          res.json({ content, offset, length: Buffer.byteLength(decoded), compressed: true });
+        }
+      );
+    });
   });
 });
 
@@ -0,0 +1,77 @@
+#include "AnsCoder.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <random>
+#include <cstring>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testAnsCoder() {
+    std::cout << "=== Testing ANS Blocks ===" << std::endl;
+
+    // Huffman needs at least a bit per byte; ANS codes a single repeated byte in none
+    std::string single(100000, 'a');
+    std::string compressed = Compressor::compress(single);
+    bool match = Compressor::decompress(compressed) == single;
+    std::cout << "Single character: " << single.length() << " -> " << compressed.length() << " bytes, match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || compressed.length() >= single.length() / 8) {
+        fail() << "Single character block not below one bit per byte!" << std::endl;
+    }
+
+    std::mt19937 rng(3);
+    std::string skewed;
+    for (int i = 0; i < 200000; i++) skewed += (rng() % 20 == 0) ? static_cast<char>('b' + rng() % 4) : 'a';
+    std::unordered_map<char, int> freqMap = Compressor::histogram(skewed);
+    std::string ans = AnsCoder::compress(skewed, freqMap);
+    match = AnsCoder::decompress(ans, skewed.length()) == skewed;
+    std::cout << "Skewed: Huffman " << Compressor::estimateHuffmanPayload(freqMap) << " bytes, ANS " << ans.length()
+              << " bytes (estimated " << AnsCoder::estimatePayload(freqMap) << "), match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || ans.length() >= Compressor::estimateHuffmanPayload(freqMap)) {
+        fail() << "ANS did not round trip or did not beat Huffman on skewed data!" << std::endl;
+    }
+
+    // Odd and even lengths exercise both interleaved states; all bytes need the largest table
+    std::string allBytes;
+    for (int i = 0; i < 256; i++) allBytes += static_cast<char>(i);
+    const std::string cases[] = {"", "x", "xy", "xyz", allBytes, allBytes + allBytes.substr(0, 77)};
+    bool allMatch = true;
+    for (const std::string& input : cases) {
+        allMatch = allMatch && AnsCoder::decompress(AnsCoder::compress(input, Compressor::histogram(input)), input.length()) == input;
+    }
+    std::cout << "Edge cases match: " << (allMatch ? "YES" : "NO") << std::endl;
+    if (!allMatch) {
+        fail() << "ANS edge case decoded incorrectly!" << std::endl;
+    }
+
+    // The length field of a one-symbol payload is all that says how much to allocate
+    std::string lying = AnsCoder::compress(single, Compressor::histogram(single));
+    uint32_t huge = 0xFFFFFFF0u;
+    std::memcpy(&lying[6], &huge, sizeof(huge));   // After the table of one symbol
+    bool rejected = false;
+    try {
+        AnsCoder::decompress(lying, single.length());
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    std::cout << "Oversized length rejected: " << (rejected ? "YES" : "NO") << std::endl;
+    if (!rejected) {
+        fail() << "ANS accepted a length larger than the block!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running ANS tests..." << std::endl << std::endl;
+
+    testAnsCoder();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
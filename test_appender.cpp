@@ -0,0 +1,81 @@
+#include "Appender.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testAppend() {
+    std::cout << "=== Testing Append ===" << std::endl;
+
+    // Same kind of lines, so the first file's table covers the appended bytes
+    std::string first, second;
+    for (int i = 0; i < 4000; i++) {
+        first += "2024-05-02 08:14:" + std::to_string(i % 60) + " INFO request " + std::to_string(i) + " ok\n";
+        second += "2024-05-03 09:20:" + std::to_string(i % 60) + " INFO request " + std::to_string(i + 4000) + " ok\n";
+    }
+
+    for (int seekable = 0; seekable <= 1; seekable++) {
+        CompressOptions options;
+        options.seekable = seekable == 1;
+        if (options.seekable) options.blockSize = Compressor::SEEKABLE_BLOCK_SIZE;
+        {
+            std::ofstream out("test_append.hfz", std::ios::binary);
+            out << Compressor::compress(first, options);
+        }
+
+        AppendResult result = Appender::append("test_append.hfz", second);
+
+        std::ifstream in("test_append.hfz", std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+
+        bool match = Compressor::decompress(data) == first + second;
+        bool rangeMatch = Compressor::decompressRange(data, first.length() - 10, 20) == (first + second).substr(first.length() - 10, 20);
+
+        size_t reuseBlocks = 0;
+        std::istringstream blocks(data, std::ios::binary);
+        blocks.seekg(sizeof(Compressor::MAGIC));
+        BlockHeader header;
+        while (Compressor::readBlockHeader(blocks, header)) {
+            if (header.mode == BLOCK_REUSE) reuseBlocks++;
+            blocks.seekg(header.payloadSize, std::ios::cur);
+        }
+
+        std::cout << (options.seekable ? "Seekable" : "Plain") << " append reused table: " << (result.reusedTable ? "YES" : "NO")
+                  << " (" << reuseBlocks << " blocks), match: " << (match && rangeMatch ? "YES" : "NO") << std::endl;
+        if (!match || !rangeMatch) {
+            fail() << "Appended file decoded incorrectly!" << std::endl;
+        }
+        if (!result.reusedTable || reuseBlocks == 0) {
+            fail() << "Appended blocks did not reuse the file's code table!" << std::endl;
+        }
+
+        std::vector<BlockIndexEntry> index;
+        std::istringstream indexStream(data, std::ios::binary);
+        if (options.seekable && (!Compressor::readIndex(indexStream, index) || index.back().rawOffset + index.back().rawSize != first.length() + second.length())) {
+            fail() << "Index does not cover the appended data!" << std::endl;
+        }
+    }
+
+    remove("test_append.hfz");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running append tests..." << std::endl << std::endl;
+
+    testAppend();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
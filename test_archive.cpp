@@ -0,0 +1,108 @@
+#include "Archive.h"
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testArchive() {
+    std::cout << "=== Testing Archive With Shared Table ===" << std::endl;
+
+    std::vector<std::string> files;
+    for (int i = 0; i < 5; i++) {
+        std::string name = "test_member_" + std::to_string(i) + ".txt";
+        std::ofstream out(name, std::ios::binary);
+        for (int j = 0; j <= i * 10; j++) {
+            out << "member " << i << " says hello to line " << j << "\n";
+        }
+        files.push_back(name);
+    }
+
+    std::string error;
+    if (!Archive::create("test_archive.hfa", files, CompressOptions(), true, error)) {
+        fail() << "Failed to create archive: " << error << std::endl;
+        return;
+    }
+
+    std::ifstream archive("test_archive.hfa", std::ios::binary);
+    std::vector<ArchiveEntry> catalog = Archive::list(archive);
+    std::cout << "Members listed: " << catalog.size() << std::endl;
+
+    bool allMatch = catalog.size() == files.size();
+    for (const auto& name : files) {
+        std::ifstream in(name, std::ios::binary);
+        std::string expected((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        archive.clear();
+        if (Archive::extract(archive, name) != expected) {
+            fail() << "Member " << name << " extracted incorrectly!" << std::endl;
+            allMatch = false;
+        }
+    }
+    std::cout << "Members match: " << (allMatch ? "YES" : "NO") << std::endl;
+
+    // Two paths that store the same member name
+    std::vector<std::string> duplicates = {files[0], "/" + files[0]};
+    bool duplicateRejected = !Archive::create("test_archive_dup.hfa", duplicates, CompressOptions(), true, error);
+    std::cout << "Duplicate member names rejected: " << (duplicateRejected ? "YES" : "NO") << std::endl;
+    if (!duplicateRejected) {
+        fail() << "Archive accepted two members with the same name!" << std::endl;
+    }
+
+    // A forged member count must fail before the catalog is allocated
+    archive.clear();
+    archive.seekg(0);
+    std::string bytes((std::istreambuf_iterator<char>(archive)), std::istreambuf_iterator<char>());
+    std::string sized = bytes;
+    const uint32_t forgedCount = 0xFFFFFFFF;
+    std::memcpy(&bytes[bytes.length() - 8], &forgedCount, sizeof(forgedCount));
+    std::istringstream forged(bytes, std::ios::binary);
+    try {
+        Archive::list(forged);
+        fail() << "Forged member count was accepted!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Forged member count rejected: " << e.what() << std::endl;
+    }
+
+    // A forged member size must fail before the member is allocated
+    uint64_t catalogOffset;
+    std::memcpy(&catalogOffset, &bytes[bytes.length() - 16], sizeof(catalogOffset));
+    const uint64_t forgedSize = 1ULL << 40;
+    size_t storedSizeAt = catalogOffset + sizeof(uint16_t) + catalog[0].name.length() + 2 * sizeof(uint64_t);
+    std::memcpy(&sized[storedSizeAt], &forgedSize, sizeof(forgedSize));
+    std::istringstream forgedMember(sized, std::ios::binary);
+    try {
+        Archive::extract(forgedMember, catalog[0].name);
+        fail() << "Forged member size was accepted!" << std::endl;
+    } catch (const std::bad_alloc&) {
+        fail() << "Forged member size was allocated!" << std::endl;
+    } catch (const std::exception& e) {
+        std::cout << "Forged member size rejected: " << e.what() << std::endl;
+    }
+
+    archive.close();
+    remove("test_archive_dup.hfa");
+    for (const auto& name : files) {
+        remove(name.c_str());
+    }
+    remove("test_archive.hfa");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running archive tests..." << std::endl << std::endl;
+
+    testArchive();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
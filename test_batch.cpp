@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+#include "Batch.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testPoolOrder() {
+    std::cout << "=== Testing Thread Pool Order ===" << std::endl;
+
+    // Both workers are held until all jobs are queued, so each queue holds
+    // its whole share; job i lands in queue i % 2 after the two gates
+    const int jobCount = 12;
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::vector<int> order;
+    std::mutex orderMutex;
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 2; ++i) {
+            pool.submit([gate] { gate.wait(); });
+        }
+        for (int i = 0; i < jobCount; ++i) {
+            pool.submit([&, i] {
+                {
+                    std::lock_guard<std::mutex> lock(orderMutex);
+                    order.push_back(i);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            });
+        }
+        release.set_value();
+        pool.wait();
+    }
+
+    // Stealing takes from the front too, so each queue runs in submission order
+    bool inOrder = static_cast<int>(order.size()) == jobCount;
+    int last[2] = {-1, -1};
+    std::cout << "Order:";
+    for (int job : order) {
+        std::cout << " " << job;
+        if (job < last[job % 2]) inOrder = false;
+        last[job % 2] = job;
+    }
+    std::cout << std::endl << "Submission order kept: " << (inOrder ? "YES" : "NO") << std::endl;
+    if (!inOrder) {
+        fail() << "Thread pool ran submitted jobs out of order!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testOutputPaths() {
+    std::cout << "=== Testing Batch Output Paths ===" << std::endl;
+
+    auto collect = [](const std::string& listing, std::vector<BatchJob>& jobs, std::string& error) {
+        {
+            std::ofstream list("test_batch_list.txt");
+            list << listing;
+        }
+        bool ok = Batch::collectJobs(BATCH_COMPRESS, "test_batch_list.txt", "out", jobs, error);
+        remove("test_batch_list.txt");
+        return ok;
+    };
+
+    std::vector<BatchJob> jobs;
+    std::string error;
+    bool collected = collect("../x.txt\n/a/f.txt\n/b/f.txt\nsub/../../y.txt\n", jobs, error);
+    bool inside = collected && jobs.size() == 4;
+    for (const BatchJob& job : jobs) {
+        std::cout << job.input << " -> " << job.output << std::endl;
+        if (job.output.find("..") != std::string::npos || job.output.rfind("out", 0) != 0) inside = false;
+    }
+    bool distinct = inside && jobs[1].output != jobs[2].output;
+
+    std::string duplicateError;
+    bool duplicateRejected = !collect("x.txt\n../x.txt\n", jobs, duplicateError);
+    std::cout << "Outputs inside out/: " << (inside ? "YES" : "NO")
+              << ", same names from different directories kept apart: " << (distinct ? "YES" : "NO")
+              << ", colliding outputs rejected: " << (duplicateRejected ? "YES" : "NO") << std::endl;
+    if (!inside || !distinct || !duplicateRejected) {
+        fail() << "Batch output paths escape the output directory or collide!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running batch tests..." << std::endl << std::endl;
+
+    testPoolOrder();
+    testOutputPaths();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+#include "BuiltinTables.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testBuiltinTables() {
+    std::cout << "=== Testing Built-in Tables ===" << std::endl;
+
+    // Every byte value must round trip through every table
+    std::string allBytes;
+    for (int i = 0; i < 256; i++) {
+        allBytes += static_cast<char>(i);
+    }
+    bool allMatch = true;
+    for (int id = 0; id < BUILTIN_TABLE_COUNT; id++) {
+        const BuiltinTable& table = BuiltinTable::get(static_cast<BuiltinTableId>(id));
+        if (table.decode(table.encode(allBytes)) != allBytes) {
+            fail() << "Table " << table.name() << " failed round trip!" << std::endl;
+            allMatch = false;
+        }
+    }
+    std::cout << "All bytes round trip: " << (allMatch ? "YES" : "NO") << std::endl;
+
+    uint64_t bits;
+    std::string sentence = "Thanks for the update, I will call you back this afternoon.";
+    std::string record = "{\"id\":7,\"status\":\"ok\",\"tags\":[\"a\",\"b\"]}";
+    bool english = std::string(BuiltinTable::best(Compressor::histogram(sentence), bits).name()) == "english";
+    bool json = std::string(BuiltinTable::best(Compressor::histogram(record), bits).name()) == "json";
+    std::cout << "English picks english: " << (english ? "YES" : "NO") << std::endl;
+    std::cout << "JSON picks json: " << (json ? "YES" : "NO") << std::endl;
+    if (!english || !json) {
+        fail() << "Best table did not match the kind of text!" << std::endl;
+    }
+
+    // A short sentence could not pay for its own tree, but a built-in table codes it
+    std::string compressed = Compressor::compress(sentence);
+    bool match = Compressor::decompress(compressed) == sentence;
+    size_t payload = compressed.length() - sizeof(Compressor::MAGIC) - Compressor::BLOCK_HEADER_SIZE;
+    std::cout << sentence.length() << " bytes -> " << compressed.length() << " bytes (payload " << payload
+              << "), match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || compressed[sizeof(Compressor::MAGIC)] != BLOCK_BUILTIN || payload * 4 > sentence.length() * 3) {
+        fail() << "Short sentence was not coded smaller with a built-in table!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running built-in table tests..." << std::endl << std::endl;
+
+    testBuiltinTables();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
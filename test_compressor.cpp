@@ -0,0 +1,291 @@
+#include "Compressor.h"
+#include "HuffmanTree.h"
+#include "Crc32c.h"
+#include <iostream>
+#include <string>
+#include <random>
+#include <sstream>
+#include <cmath>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testContainerRoundTrip() {
+    std::cout << "=== Testing Compressed Container ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 500; i++) {
+        text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 7) + "\n";
+    }
+
+    CompressOptions options;
+    options.blockSize = 4096;   // Force several blocks
+    for (int level : {0, 1, 9}) {
+        options.lzLevel = level;
+        std::string compressed = Compressor::compress(text, options);
+        std::string decoded = Compressor::decompress(compressed);
+
+        std::cout << "LZ level " << level << ": " << compressed.length() << " bytes, match: "
+                  << (text == decoded ? "YES" : "NO") << std::endl;
+        if (text != decoded) {
+            fail() << "Container round trip failed!" << std::endl;
+        }
+    }
+
+    std::string empty = Compressor::decompress(Compressor::compress(""));
+    std::cout << "Empty input round trip: " << (empty.empty() ? "YES" : "NO") << std::endl;
+    if (!empty.empty()) {
+        fail() << "Empty input did not round trip!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testSizeEstimate() {
+    std::cout << "=== Testing Histogram Size Estimate ===" << std::endl;
+
+    std::string text = "hi this is teja testing out his new project";
+    HuffmanTree huffman;
+    huffman.buildTree(text);
+    std::string encoded = huffman.encode(text);
+
+    uint64_t estimated = HuffmanTree::estimateEncodedBits(Compressor::histogram(text));
+    std::cout << "Encoded bits:   " << encoded.length() << std::endl;
+    std::cout << "Estimated bits: " << estimated << std::endl;
+    std::cout << "Match: " << (estimated == encoded.length() ? "YES" : "NO") << std::endl;
+
+    if (estimated != encoded.length()) {
+        fail() << "Size estimate does not match encoder output!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testStoredBypass() {
+    std::cout << "=== Testing Stored Block Bypass ===" << std::endl;
+
+    std::mt19937 rng(42);
+    std::string random(50000, '\0');
+    for (char& ch : random) {
+        ch = static_cast<char>(rng() & 0xFF);
+    }
+
+    for (const std::string& text : {random, std::string("hi")}) {
+        std::string compressed = Compressor::compress(text);
+        std::string decoded = Compressor::decompress(compressed);
+
+        // Stored blocks add only the magic and one block header
+        size_t overhead = compressed.length() - text.length();
+        std::cout << text.length() << " bytes -> " << compressed.length() << " bytes (overhead "
+                  << overhead << "), match: " << (text == decoded ? "YES" : "NO") << std::endl;
+        if (text != decoded || overhead != Compressor::BLOCK_HEADER_SIZE + sizeof(Compressor::MAGIC)) {
+            fail() << "Incompressible input was not stored raw!" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+void testChecksumDetectsCorruption() {
+    std::cout << "=== Testing Block Checksum ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 300; i++) {
+        text += "checksum line " + std::to_string(i) + "\n";
+    }
+
+    std::string compressed = Compressor::compress(text);
+    std::cout << "Hardware CRC32C: " << (crc32cHardwareAccelerated() ? "YES" : "NO") << std::endl;
+
+    // Flip one bit of the first block's stored checksum; the payload still
+    // decodes, so only the checksum comparison can reject it
+    compressed[sizeof(Compressor::MAGIC) + 9] ^= 0x01;
+    const std::string expected = "Checksum mismatch in block 0";
+    try {
+        Compressor::decompress(compressed);
+        fail() << "Corrupted block decoded without error!" << std::endl;
+    } catch (const std::exception& e) {
+        if (e.what() == expected) {
+            std::cout << "Corruption correctly detected: " << e.what() << std::endl;
+        } else {
+            fail() << "Expected \"" << expected << "\", got: " << e.what() << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+void testRangeDecode() {
+    std::cout << "=== Testing Seekable Range Decode ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 5000; i++) {
+        text += "log line " + std::to_string(i) + " status=ok\n";
+    }
+
+    CompressOptions options;
+    options.seekable = true;
+    options.blockSize = 4096;
+    std::string compressed = Compressor::compress(text, options);
+
+    std::vector<BlockIndexEntry> index;
+    std::istringstream in(compressed, std::ios::binary);
+    bool hasIndex = Compressor::readIndex(in, index);
+    std::cout << "Index present: " << (hasIndex ? "YES" : "NO") << ", blocks: " << index.size() << std::endl;
+    if (!hasIndex || index.size() < 2) {
+        fail() << "Seekable output has no index over several blocks!" << std::endl;
+        return;
+    }
+
+    bool allMatch = Compressor::decompress(compressed) == text;
+    const uint64_t ranges[][2] = {{0, 10}, {4090, 20}, {50000, 9000}, {text.length() - 5, 100}, {text.length() + 10, 5}};
+    for (const auto& range : ranges) {
+        std::string expected = range[0] < text.length() ? text.substr(range[0], range[1]) : "";
+        std::string got = Compressor::decompressRange(compressed, range[0], range[1]);
+        if (got != expected) {
+            fail() << "Range [" << range[0] << ", +" << range[1] << ") decoded incorrectly!" << std::endl;
+            allMatch = false;
+        }
+    }
+    std::cout << "Ranges match: " << (allMatch ? "YES" : "NO") << std::endl;
+
+    // Indexes that misplace the blocks must not be trusted
+    std::string blocks = compressed.substr(0, compressed.length() - Compressor::frameIndex(index).length());
+    std::vector<BlockIndexEntry> moved = index, reordered = index, shortened = index;
+    moved[0].fileOffset += 1;
+    reordered[1].fileOffset = reordered[0].fileOffset;
+    shortened.pop_back();
+    int rejected = 0;
+    for (const auto* forged : {&moved, &reordered, &shortened}) {
+        std::istringstream forgedIn(blocks + Compressor::frameIndex(*forged), std::ios::binary);
+        std::vector<BlockIndexEntry> forgedIndex;
+        try {
+            Compressor::readIndex(forgedIn, forgedIndex);
+        } catch (const std::runtime_error&) {
+            rejected++;
+        }
+    }
+    std::cout << "Forged indexes rejected: " << rejected << " of 3" << std::endl;
+    if (rejected != 3) {
+        fail() << "A forged block index was accepted!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testDedup() {
+    std::cout << "=== Testing Dedup ===" << std::endl;
+
+    std::mt19937 rng(7);
+    std::string snapshot;
+    for (int i = 0; i < 3000; i++) {
+        snapshot += "{\"id\":" + std::to_string(rng() % 100000) + ",\"name\":\"user" + std::to_string(rng() % 997) + "\"}\n";
+    }
+    std::string text;
+    for (int copy = 0; copy < 4; copy++) {
+        std::string edited = snapshot;
+        edited.insert(edited.length() / 3, "{\"edit\":" + std::to_string(copy) + "}\n");
+        text += edited;
+    }
+
+    for (int seekable = 0; seekable <= 1; seekable++) {
+        CompressOptions options;
+        options.seekable = seekable == 1;
+        if (options.seekable) options.blockSize = Compressor::SEEKABLE_BLOCK_SIZE;
+        std::string plain = Compressor::compress(text, options);
+        options.dedup = true;
+        std::string deduped = Compressor::compress(text, options);
+
+        bool match = Compressor::decompress(deduped) == text;
+        bool rangeMatch = !options.seekable || Compressor::decompressRange(deduped, text.length() / 2, 5000) == text.substr(text.length() / 2, 5000);
+        std::cout << (options.seekable ? "Seekable" : "Plain") << " dedup: " << plain.length() << " -> " << deduped.length()
+                  << " bytes, match: " << (match && rangeMatch ? "YES" : "NO") << std::endl;
+        if (!match || !rangeMatch) {
+            fail() << "Deduplicated file decoded incorrectly!" << std::endl;
+        }
+        if (deduped.length() >= plain.length()) {
+            fail() << "Dedup did not shrink repeated content!" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+void testLevels() {
+    std::cout << "=== Testing Levels ===" << std::endl;
+
+    // Text, then random bytes, then numbers: long enough to sample, with statistics that change mid-block
+    std::mt19937 rng(21);
+    std::string text;
+    while (text.length() < 700000) {
+        text += "word" + std::to_string(static_cast<int>(3000.0 / (1 + rng() % 3000))) + (rng() % 9 == 0 ? ".\n" : " ");
+    }
+    for (int i = 0; i < 200000; i++) text += static_cast<char>(rng() % 256);
+    while (text.length() < 1500000) text += std::to_string(rng() % 100000) + ",";
+
+    bool allMatch = true;
+    size_t sizes[Compressor::MAX_LEVEL + 1] = {0};
+    for (int level = Compressor::MIN_LEVEL; level <= Compressor::MAX_LEVEL; level++) {
+        CompressOptions options;
+        Compressor::applyLevel(options, level);
+        std::string compressed = Compressor::compress(text, options);
+        sizes[level] = compressed.length();
+        allMatch = allMatch && Compressor::decompress(compressed) == text;
+    }
+    std::cout << "Level 1: " << sizes[1] << ", level 3: " << sizes[3] << ", level 9: " << sizes[9] << " bytes" << std::endl;
+    std::cout << "All levels match: " << (allMatch ? "YES" : "NO") << std::endl;
+    if (!allMatch || sizes[9] > sizes[3]) {
+        fail() << "A level did not round trip, or level 9 was larger than level 3!" << std::endl;
+    }
+
+    CompressOptions defaults, three;
+    Compressor::applyLevel(three, Compressor::DEFAULT_LEVEL);
+    if (Compressor::compress(text, defaults) != Compressor::compress(text, three)) {
+        fail() << "Default level differs from the default options!" << std::endl;
+    }
+
+    // Word blocks each carry their vocabulary, so splitting them on ANS
+    // estimates, which ignore it, must not make the output larger
+    std::mt19937 wordRng(7);
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 4000; i++) {
+        std::string word;
+        int wordLength = 2 + wordRng() % 8;
+        for (int j = 0; j < wordLength; j++) word += char('a' + wordRng() % 26);
+        vocabulary.push_back(word);
+    }
+    std::string wordText;
+    std::uniform_real_distribution<double> unit(0, 1);
+    while (wordText.length() < (1 << 20)) {
+        // Zipf-like ranks; which words are common drifts every 64 KB
+        size_t rank = size_t(std::pow(double(vocabulary.size()), unit(wordRng))) - 1;
+        wordText += vocabulary[(rank + wordText.length() / (64 << 10) * 97) % vocabulary.size()];
+        wordText += wordRng() % 12 == 0 ? ".\n" : " ";
+    }
+    CompressOptions split, whole;
+    Compressor::applyLevel(split, Compressor::MAX_LEVEL);
+    Compressor::applyLevel(whole, Compressor::MAX_LEVEL);
+    whole.splitSize = 0;
+    size_t splitSize = Compressor::compress(wordText, split).length();
+    size_t wholeSize = Compressor::compress(wordText, whole).length();
+    std::cout << "Word blocks split: " << splitSize << " bytes, whole: " << wholeSize << " bytes" << std::endl;
+    if (splitSize > wholeSize) {
+        fail() << "Splitting word-coded blocks made the output larger!" << std::endl;
+    }
+
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running compressed container tests..." << std::endl << std::endl;
+
+    testContainerRoundTrip();
+    testSizeEstimate();
+    testStoredBypass();
+    testChecksumDetectsCorruption();
+    testRangeDecode();
+    testDedup();
+    testLevels();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include "LZ77.h"
+#include <iostream>
+#include <string>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testParseExpand() {
+    std::cout << "=== Testing LZ77 Parse/Expand ===" << std::endl;
+
+    std::string text = "abcabcabcabcabcXYZabcabc";
+    LZ77 lz;
+    LZ77Parse parsed = lz.parse(text);
+    std::string expanded = LZ77::expand(parsed);
+
+    std::cout << "Sequences: " << parsed.sequences.size() << std::endl;
+    std::cout << "Literals:  " << parsed.literals << std::endl;
+    std::cout << "Match: " << (text == expanded ? "YES" : "NO") << std::endl;
+
+    if (text != expanded) {
+        fail() << "LZ77 parse/expand failed!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testLevels() {
+    std::cout << "=== Testing LZ77 Levels ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 200; i++) {
+        text += "{\"id\":" + std::to_string(i) + ",\"status\":\"ok\",\"message\":\"request processed\"}\n";
+    }
+
+    size_t previous = 0;
+    for (int level = LZ77::MIN_LEVEL; level <= LZ77::MAX_LEVEL; level++) {
+        LZ77 lz(level);
+        std::string payload = lz.compress(text);
+        std::string decoded = LZ77::decompress(payload);
+
+        std::cout << "Level " << level << ": " << text.length() << " -> " << payload.length()
+                  << " bytes, match: " << (text == decoded ? "YES" : "NO") << std::endl;
+        if (text != decoded) {
+            fail() << "LZ77 level " << level << " round trip failed!" << std::endl;
+        }
+        if (level > LZ77::MIN_LEVEL && payload.length() > previous) {
+            fail() << "LZ77 level " << level << " is larger than level " << level - 1 << "!" << std::endl;
+        }
+        previous = payload.length();
+    }
+    std::cout << std::endl;
+}
+
+void testOverlappingMatch() {
+    std::cout << "=== Testing Overlapping Match ===" << std::endl;
+
+    std::string text = "x" + std::string(1000, 'a');
+    std::string decoded = LZ77::decompress(LZ77().compress(text));
+
+    std::cout << "Match: " << (text == decoded ? "YES" : "NO") << std::endl;
+    if (text != decoded) {
+        fail() << "Overlapping match failed!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running LZ77 tests..." << std::endl << std::endl;
+
+    testParseExpand();
+    testLevels();
+    testOverlappingMatch();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
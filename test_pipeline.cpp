@@ -0,0 +1,108 @@
+#include "Pipeline.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testPipeline() {
+    std::cout << "=== Testing Pipelined File Compression ===" << std::endl;
+
+    std::string text;
+    for (int i = 0; i < 3000; i++) {
+        text += "{\"id\":" + std::to_string(i) + ",\"event\":\"pipeline\"}\n";
+    }
+    {
+        std::ofstream out("test_pipeline_in.txt", std::ios::binary);
+        out << text;
+    }
+
+    // Small blocks so several are in flight at once
+    CompressOptions options;
+    options.blockSize = 4096;
+    options.lzLevel = 3;
+    options.seekable = true;
+
+    PipelineResult compressed = Pipeline::compressFile("test_pipeline_in.txt", "test_pipeline.hfz", options);
+    std::cout << "Async I/O: " << (compressed.async ? "YES" : "NO") << std::endl;
+
+    std::ifstream in("test_pipeline.hfz", std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    bool identical = written == Compressor::compress(text, options) && written.length() == compressed.outputBytes;
+    std::cout << "Same bytes as in-memory compress: " << (identical ? "YES" : "NO") << std::endl;
+    if (!identical) {
+        fail() << "Pipelined output differs from in-memory compress!" << std::endl;
+    }
+
+    Pipeline::decompressFile("test_pipeline.hfz", "test_pipeline_out.txt");
+    std::ifstream check("test_pipeline_out.txt", std::ios::binary);
+    std::string decoded((std::istreambuf_iterator<char>(check)), std::istreambuf_iterator<char>());
+    check.close();
+    std::cout << "Match: " << (decoded == text ? "YES" : "NO") << std::endl;
+    if (decoded != text) {
+        fail() << "Pipelined round trip failed!" << std::endl;
+    }
+
+    // A failed decompress must not leave the blocks before the bad one behind,
+    // so the checksum of the second block is the one broken
+    uint32_t firstPayload;
+    std::memcpy(&firstPayload, written.data() + sizeof(Compressor::MAGIC) + 5, sizeof(firstPayload));
+    written[sizeof(Compressor::MAGIC) + Compressor::BLOCK_HEADER_SIZE + firstPayload + 9] ^= 0x10;
+    {
+        std::ofstream out("test_pipeline.hfz", std::ios::binary);
+        out << written;
+    }
+    remove("test_pipeline_out.txt");
+    bool failed = false;
+    try {
+        Pipeline::decompressFile("test_pipeline.hfz", "test_pipeline_out.txt");
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    bool removed = !std::ifstream("test_pipeline_out.txt").good();
+    std::cout << "Corrupt input rejected: " << (failed ? "YES" : "NO")
+              << ", partial output removed: " << (removed ? "YES" : "NO") << std::endl;
+    if (!failed || !removed) {
+        fail() << "Failed pipelined decompress left output behind!" << std::endl;
+    }
+
+    // Compressing a file onto itself must fail before the file is truncated
+    bool sameRejected = false;
+    try {
+        Pipeline::compressFile("test_pipeline_in.txt", "test_pipeline_in.txt", options);
+    } catch (const std::exception&) {
+        sameRejected = true;
+    }
+    std::ifstream same("test_pipeline_in.txt", std::ios::binary);
+    std::string kept((std::istreambuf_iterator<char>(same)), std::istreambuf_iterator<char>());
+    same.close();
+    std::cout << "Same input and output rejected: " << (sameRejected ? "YES" : "NO")
+              << ", input kept: " << (kept == text ? "YES" : "NO") << std::endl;
+    if (!sameRejected || kept != text) {
+        fail() << "Pipelined compress onto its own input lost data!" << std::endl;
+    }
+
+    remove("test_pipeline_in.txt");
+    remove("test_pipeline.hfz");
+    remove("test_pipeline_out.txt");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running pipeline tests..." << std::endl << std::endl;
+
+    testPipeline();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
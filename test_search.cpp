@@ -0,0 +1,71 @@
+#include "Search.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <random>
+#include <sstream>
+#include <cstdint>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testSearch() {
+    std::cout << "=== Testing Search ===" << std::endl;
+
+    std::mt19937 rng(5);
+    std::string text;
+    while (text.length() < 8 * Compressor::SEEKABLE_BLOCK_SIZE) {
+        text += "event " + std::to_string(rng() % 5000) + " from host" + std::to_string(rng() % 40) + " took " + std::to_string(rng() % 900) + "ms\n";
+    }
+    text.insert(3 * Compressor::SEEKABLE_BLOCK_SIZE + 100, "needle-in-block");
+
+    // Patterns inside one block, absent, and straddling block boundaries (short and longer than the stored edges)
+    size_t boundary = 5 * Compressor::SEEKABLE_BLOCK_SIZE;
+    const std::string patterns[] = {"needle-in-block", "host7 took", "no such text", "zebra",
+                                    text.substr(boundary - 4, 9), text.substr(boundary - 50, 120)};
+
+    for (int searchable = 0; searchable <= 1; searchable++) {
+        CompressOptions options;
+        options.seekable = true;
+        options.blockSize = Compressor::SEEKABLE_BLOCK_SIZE;
+        options.searchable = searchable == 1;
+        std::istringstream in(Compressor::compress(text, options), std::ios::binary);
+
+        bool allMatch = true;
+        size_t decoded = 0;
+        for (const std::string& pattern : patterns) {
+            std::vector<uint64_t> expected;
+            for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1)) {
+                expected.push_back(at);
+            }
+            in.clear();
+            in.seekg(0);
+            SearchResult result = Search::find(in, pattern, SIZE_MAX);
+            allMatch = allMatch && result.matches == expected.size() && result.offsets == expected;
+            decoded += result.decodedBlocks;
+        }
+        std::cout << (options.searchable ? "With filters" : "Without filters") << ": decoded " << decoded
+                  << " blocks, match: " << (allMatch ? "YES" : "NO") << std::endl;
+        if (!allMatch) {
+            fail() << "Search results differ from a plain scan!" << std::endl;
+        }
+        if (options.searchable && decoded >= 6 * 8) {
+            fail() << "Filters did not skip any blocks!" << std::endl;
+        }
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running search tests..." << std::endl << std::endl;
+
+    testSearch();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "Trace.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testTrace() {
+    std::cout << "=== Testing Trace ===" << std::endl;
+
+    // A second thread overruns its ring by 10 events; the main thread records one
+    Trace::start();
+    std::thread worker([] {
+        for (size_t i = 0; i < Trace::EVENTS_PER_THREAD + 10; ++i) {
+            Trace::record("worker_event", Trace::nowNs(), Trace::nowNs(), "index", i);
+        }
+    });
+    worker.join();
+    Trace::record("main_event", Trace::nowNs(), Trace::nowNs(), nullptr, 0);
+#ifdef HUFFMAN_TRACE
+    Compressor::decompress(Compressor::compress(std::string(300000, 'q')));
+#endif
+
+    bool written = Trace::writeChromeJson("test_trace.json");
+    std::ifstream in("test_trace.json", std::ios::binary);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    bool wrapped = json.find("\"dropped_events\":10}") != std::string::npos &&
+                   json.find("\"index\":9}") == std::string::npos &&
+                   json.find("\"index\":" + std::to_string(Trace::EVENTS_PER_THREAD + 9) + "}") != std::string::npos;
+    bool bothThreads = json.find("\"main_event\"") != std::string::npos && json.find("\"tid\":1") != std::string::npos;
+    bool blocks = !Trace::compiledIn() ||
+                  (json.find("\"encode_block\"") != std::string::npos && json.find("\"decode_block\"") != std::string::npos);
+    std::cout << "Written: " << (written ? "YES" : "NO") << ", oldest events overwritten: " << (wrapped ? "YES" : "NO")
+              << ", both threads: " << (bothThreads ? "YES" : "NO") << ", block scopes: " << (blocks ? "YES" : "NO") << std::endl;
+    if (!written || !wrapped || !bothThreads || !blocks) {
+        fail() << "Trace output is missing events or kept overwritten ones!" << std::endl;
+    }
+
+    remove("test_trace.json");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running trace tests..." << std::endl << std::endl;
+
+    testTrace();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "Updater.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <random>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testUpdate() {
+    std::cout << "=== Testing Update ===" << std::endl;
+
+    std::mt19937 rng(17);
+    std::string text;
+    while (text.length() < 1500000) {
+        text += "row " + std::to_string(rng() % 100000) + " value " + std::to_string(rng() % 977) + "\n";
+    }
+    // An insertion, a deletion and an overwrite, far apart
+    std::string edited = text.substr(0, 300000) + "a brand new line\n" + text.substr(300000, 400000) +
+                         text.substr(702000, 300000) + std::string(50, '#') + text.substr(1002050);
+
+    CompressOptions options;
+    options.contentDefined = true;
+    options.seekable = true;
+    {
+        std::ofstream out("test_update.hfz", std::ios::binary);
+        out << Compressor::compress(text, options);
+    }
+
+    // A file at the old fixed temporary name belongs to someone else
+    {
+        std::ofstream out("test_update.hfz.tmp", std::ios::binary);
+        out << "not ours";
+    }
+    UpdateResult result = Updater::update("test_update.hfz", edited);
+    std::ifstream other("test_update.hfz.tmp", std::ios::binary);
+    std::string otherData((std::istreambuf_iterator<char>(other)), std::istreambuf_iterator<char>());
+    other.close();
+    remove("test_update.hfz.tmp");
+    if (otherData != "not ours") {
+        fail() << "Update wrote into an existing test_update.hfz.tmp!" << std::endl;
+    }
+    std::ifstream in("test_update.hfz", std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    bool match = Compressor::decompress(data) == edited;
+    bool fresh = data == Compressor::compress(edited, options);
+    std::cout << "Reused " << result.reusedBlocks << " of " << result.blocks << " blocks, encoded " << result.encodedBytes
+              << " bytes, match: " << (match ? "YES" : "NO") << ", same as fresh compress: " << (fresh ? "YES" : "NO") << std::endl;
+    if (!match || !fresh || result.encodedBytes * 4 > edited.length()) {
+        fail() << "Update decoded incorrectly, differed from compress, or re-encoded too much!" << std::endl;
+    }
+
+    // A damaged first block fails the update after the temporary file exists
+    uint32_t firstPayload = 0;
+    std::memcpy(&firstPayload, data.data() + sizeof(Compressor::MAGIC) + 5, sizeof(firstPayload));
+    data[sizeof(Compressor::MAGIC) + Compressor::BLOCK_HEADER_SIZE + firstPayload / 2] ^= 0x10;
+    {
+        std::ofstream out("test_update.hfz", std::ios::binary);
+        out << data;
+    }
+    bool failed = false;
+    try {
+        Updater::update("test_update.hfz", edited);
+    } catch (const std::exception&) {
+        failed = true;
+    }
+    bool tempRemoved = true;
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        if (entry.path().filename().string().rfind("test_update.hfz.tmp", 0) == 0) {
+            tempRemoved = false;
+            std::filesystem::remove(entry.path());
+        }
+    }
+    std::cout << "Failed update leaves no temporary file: " << (failed && tempRemoved ? "YES" : "NO") << std::endl;
+    if (!failed || !tempRemoved) {
+        fail() << "Failed update did not fail or left a temporary file behind!" << std::endl;
+    }
+
+    remove("test_update.hfz");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running update tests..." << std::endl << std::endl;
+
+    testUpdate();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include "WordCoder.h"
+#include "Compressor.h"
+#include <iostream>
+#include <string>
+#include <random>
+
+int failures = 0;
+
+// Prints an ERROR line; main returns nonzero if any were printed
+std::ostream& fail() {
+    ++failures;
+    return std::cout << "ERROR: ";
+}
+
+void testWordMode() {
+    std::cout << "=== Testing Word Mode ===" << std::endl;
+
+    // Zipf-like word choice gives a large vocabulary with codes beyond the lookup table
+    std::mt19937 rng(11);
+    std::string text;
+    for (int i = 0; i < 60000; i++) {
+        int rank = static_cast<int>(5000.0 / (1 + rng() % 5000));
+        text += "word" + std::to_string(rank * 7919 % 10007);
+        text += (i % 17 == 0) ? ".\n" : (i % 5 == 0 ? ", " : " ");
+    }
+
+    CompressOptions options;
+    std::string bytes = Compressor::compress(text, options);
+    options.words = true;
+    std::string words = Compressor::compress(text, options);
+    bool match = Compressor::decompress(words) == text;
+    std::cout << "Prose: " << bytes.length() << " -> " << words.length() << " bytes, match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || words.length() >= bytes.length()) {
+        fail() << "Word mode did not round trip or did not shrink prose!" << std::endl;
+    }
+
+    // Edge cases straight through the coder: nothing, one token, tokens over the length cap, all bytes
+    std::string allBytes;
+    for (int i = 0; i < 256; i++) allBytes += static_cast<char>(i);
+    const std::string cases[] = {"", "hello", std::string(700, 'x') + std::string(300, ' '), allBytes + allBytes};
+    bool allMatch = true;
+    for (const std::string& input : cases) {
+        allMatch = allMatch && WordCoder::decompress(WordCoder::compress(input)) == input;
+    }
+    std::cout << "Edge cases match: " << (allMatch ? "YES" : "NO") << std::endl;
+    if (!allMatch) {
+        fail() << "Word coder edge case decoded incorrectly!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void testOptimalCodes() {
+    std::cout << "=== Testing Length-Limited Word Codes ===" << std::endl;
+
+    std::mt19937 rng(11);
+    std::string text;
+    for (int i = 0; i < 60000; i++) {
+        int rank = static_cast<int>(5000.0 / (1 + rng() % 5000));
+        text += "word" + std::to_string(rank * 7919 % 10007) + " ";
+    }
+
+    // No code reaches the limit here, so both methods are plain Huffman and agree byte for byte
+    std::string flattened = WordCoder::compress(text);
+    std::string optimal = WordCoder::compress(text, true);
+    bool match = WordCoder::decompress(optimal) == text;
+    std::cout << "Word codes: " << flattened.length() << " -> " << optimal.length() << " bytes, match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || optimal != flattened) {
+        fail() << "Optimal word codes did not round trip or changed codes within the limit!" << std::endl;
+    }
+
+    // Fibonacci counts give a Huffman tree one level deeper per word, so 27
+    // words need codes past MAX_CODE_LENGTH and the two methods must differ
+    std::string deep;
+    uint32_t previous = 1, count = 1;
+    for (int word = 0; word < 27; word++) {
+        std::string token = word < 26 ? std::string(1, static_cast<char>('a' + word)) : "zz";
+        for (uint32_t i = 0; i < count; i++) deep += token + " ";
+        uint32_t next = previous + count;
+        previous = count;
+        count = next;
+    }
+    flattened = WordCoder::compress(deep);
+    optimal = WordCoder::compress(deep, true);
+    match = WordCoder::decompress(optimal) == deep && WordCoder::decompress(flattened) == deep;
+    std::cout << "Deep word codes: " << flattened.length() << " -> " << optimal.length() << " bytes, match: " << (match ? "YES" : "NO") << std::endl;
+    if (!match || optimal.length() >= flattened.length()) {
+        fail() << "Length-limited codes did not round trip or were not smaller than flattened ones!" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "Running word coder tests..." << std::endl << std::endl;
+
+    testWordMode();
+    testOptimalCodes();
+
+    std::cout << "All tests completed." << std::endl;
+    return failures == 0 ? 0 : 1;
+}